@@ -0,0 +1,677 @@
+/* bench.c - RayComposer device API benchmark
+ *
+ * Measures frame and DMX throughput and buffer wake-up timing of the
+ * devices found by RCEnumerateDevices(). Runs against real devices or the
+ * virtual devices of api-sim. Results are printed as CSV on stdout, one
+ * header line per table, progress and errors on stderr.
+ *
+ * Usage: bench [duration in ms per test, default 1000] [maximum number of devices]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "rcdev.h"
+#include "rcutil.h"
+
+#define MAX_DEVICES 16
+
+struct Device {
+  int handle;
+  int maxSpeed;
+  /* first output and input universe, -1 if the device has none */
+  int dmxOut;
+  int dmxIn;
+};
+
+/* Parameters and results of one frame throughput run on one device */
+struct FrameRun {
+  struct Device *device;
+  struct RCPoint *points;
+  unsigned int count;
+  unsigned int speed;
+  long long duration;
+  /* results */
+  unsigned long long frames;
+  /* frames played and time between the first and the last wake-up with
+   * full buffers; frames that only filled the empty buffers are excluded */
+  unsigned long long steadyFrames;
+  long long steadyTime;
+  long long waitTotal;
+  long long writeTotal;
+  long long writeMax;
+  /* deviation of the intervals between frames from the frame duration */
+  double jitterSum;
+  double jitterSquares;
+  double jitterMax;
+  int error;
+};
+
+static struct Device devices[MAX_DEVICES];
+static int deviceCount;
+
+static void fillCircle(struct RCPoint *points, unsigned int count){
+  unsigned int i;
+  for(i = 0; i < count; i++){
+    double phi = (double)i * 6.283185307179586 / count;
+    points[i].x = (signed short)(sin(phi) * 32767.0);
+    points[i].y = (signed short)(cos(phi) * 32767.0);
+    points[i].red = 65535;
+    points[i].green = 65535;
+    points[i].blue = 65535;
+    points[i].intensity = 65535;
+    points[i].user1 = 0;
+    points[i].user2 = 0;
+  }
+}
+
+/* Write frames with repeat = 1 for run->duration microseconds. */
+static void frameRun(struct FrameRun *run){
+  int handle = run->device->handle;
+  long long frameTime = (long long)run->count * 1000000 / run->speed;
+  long long start, end, lastReady = 0, steadyStart = 0;
+  unsigned long long intervals = 0, steadyFirst = 0;
+
+  run->frames = run->steadyFrames = 0;
+  run->steadyTime = 0;
+  run->waitTotal = run->writeTotal = run->writeMax = 0;
+  run->jitterSum = run->jitterSquares = run->jitterMax = 0.0;
+  run->error = RCOk;
+
+  start = RCUClock();
+  end = start + run->duration;
+  for(;;){
+    long long t0, t1, t2;
+    int ret;
+    t0 = RCUClock();
+    if(t0 >= end){
+      break;
+    }
+    ret = RCWaitForReady(handle, -1);
+    t1 = RCUClock();
+    if(ret < RCOk){
+      run->error = ret;
+      break;
+    }
+    /* Once the buffers are full every wake-up should be one frame apart. */
+    if(t1 - t0 > frameTime / 4){
+      /* With full buffers before and after, frames written in between were
+       * also played in between. */
+      if(steadyStart == 0){
+        steadyStart = t1;
+        steadyFirst = run->frames;
+      } else {
+        run->steadyFrames = run->frames - steadyFirst;
+        run->steadyTime = t1 - steadyStart;
+      }
+      if(lastReady != 0){
+        double jitter = fabs((double)(t1 - lastReady - frameTime));
+        run->jitterSum += jitter;
+        run->jitterSquares += jitter * jitter;
+        if(jitter > run->jitterMax){
+          run->jitterMax = jitter;
+        }
+        intervals++;
+      }
+      lastReady = t1;
+    } else {
+      lastReady = 0;
+    }
+    ret = RCWriteFrame(handle, run->points, run->count, run->speed, 1);
+    t2 = RCUClock();
+    if(ret < RCOk){
+      run->error = ret;
+      break;
+    }
+    run->waitTotal += t1 - t0;
+    run->writeTotal += t2 - t1;
+    if(t2 - t1 > run->writeMax){
+      run->writeMax = t2 - t1;
+    }
+    run->frames++;
+  }
+  if(intervals > 0){
+    run->jitterSum /= (double)intervals;
+    run->jitterSquares = sqrt(run->jitterSquares / (double)intervals);
+  }
+}
+
+/* Parameters and results of one concurrent call run on one device */
+struct CallRun {
+  struct Device *device;
+  long long duration;
+  /* results */
+  unsigned long long calls;
+  long long elapsed;
+  int error;
+};
+
+/* Call the non-blocking device functions in a loop for run->duration
+ * microseconds; measures how calls on different handles scale. */
+static void callRun(struct CallRun *run){
+  int handle = run->device->handle;
+  int universe = run->device->dmxOut;
+  unsigned char data[16];
+  long long start, end;
+  int ret = RCOk;
+
+  memset(data, 0, sizeof(data));
+  run->calls = 0;
+  start = RCUClock();
+  end = start + run->duration;
+  do{
+    unsigned int i;
+    for(i = 0; i < 64 && ret >= RCOk; i++){
+      data[0] = (unsigned char)i;
+      ret = RCWaitForReady(handle, 0);
+      run->calls++;
+      if(universe < 0){
+        continue;
+      }
+      if(ret >= RCOk){
+        ret = RCUniverseWrite(handle, (unsigned int)universe, 0, data, sizeof(data));
+      }
+      if(ret >= RCOk){
+        ret = RCUniverseUpdate(handle, (unsigned int)universe);
+      }
+      run->calls += 2;
+    }
+  } while(ret >= RCOk && RCUClock() < end);
+  run->elapsed = RCUClock() - start;
+  run->error = ret < RCOk ? ret : RCOk;
+}
+
+/* Parameters and results of one stress run on one device, or of the
+ * enumeration running next to them if device is NULL */
+struct StressRun {
+  struct Device *device;
+  unsigned int index;
+  long long duration;
+  /* results */
+  unsigned long long frames;
+  unsigned long long frameErrors;
+  unsigned long long dmxChecks;
+  unsigned long long dmxErrors;
+  unsigned long long enumerations;
+  long long elapsed;
+  int error;
+};
+
+/* Enumerate the devices in a loop while the other threads use their handles. */
+static void stressEnumerate(struct StressRun *run){
+  char deviceId[256];
+  long long start = RCUClock();
+  int ret = RCOk;
+  do{
+    int count = RCEnumerateDevices(), i;
+    if(count < RCOk){
+      ret = count;
+      break;
+    }
+    for(i = 0; i < count && ret >= RCOk; i++){
+      ret = RCDeviceID((unsigned int)i, deviceId, sizeof(deviceId));
+    }
+    run->enumerations++;
+  } while(ret >= RCOk && RCUClock() - start < run->duration);
+  run->elapsed = RCUClock() - start;
+  run->error = ret < RCOk ? ret : RCOk;
+}
+
+/* Write frames and DMX data with a pattern unique to the device and check
+ * that the device state matches what this thread wrote:
+ *  - RCWaitForReady() never reports more free buffers than the device has,
+ *  - the frames can not have played faster than in real time and all
+ *    buffers are free again once they have played,
+ *  - DMX input returns this device's output pattern if the device loops
+ *    its output back (always true for the virtual devices). */
+static void stressRun(struct StressRun *run){
+  struct RCPoint points[100];
+  unsigned char out[16], in[16];
+  int handle, buffers, ret, loopback = 0;
+  unsigned int speed, i;
+  long long frameTime, start, end;
+
+  if(run->device == NULL){
+    stressEnumerate(run);
+    return;
+  }
+  handle = run->device->handle;
+  speed = (unsigned int)run->device->maxSpeed;
+  frameTime = 100LL * 1000000 / speed;
+  fillCircle(points, 100);
+
+  /* output was restarted, so all buffers are free */
+  buffers = RCWaitForReady(handle, 0);
+  if(buffers <= 0){
+    run->error = buffers < RCOk ? buffers : RCErrorIO;
+    return;
+  }
+  if(run->device->dmxOut >= 0 && run->device->dmxIn >= 0){
+    memset(out, (int)(0xA0 + run->index), sizeof(out));
+    ret = RCUniverseWrite(handle, (unsigned int)run->device->dmxOut, 0, out, sizeof(out));
+    if(ret >= RCOk){
+      ret = RCUniverseUpdate(handle, (unsigned int)run->device->dmxOut);
+    }
+    if(ret >= RCOk){
+      ret = RCUniverseRead(handle, (unsigned int)run->device->dmxIn, 0, in, sizeof(in));
+    }
+    loopback = ret >= RCOk && memcmp(in, out, sizeof(out)) == 0;
+  }
+
+  ret = RCOk;
+  start = RCUClock();
+  end = start + run->duration;
+  while(RCUClock() < end){
+    ret = RCWaitForReady(handle, -1);
+    if(ret < RCOk){
+      break;
+    }
+    if(ret < 1 || ret > buffers){
+      run->frameErrors++;
+    }
+    ret = RCWriteFrame(handle, points, 100, speed, 1);
+    if(ret < RCOk){
+      break;
+    }
+    run->frames++;
+    if(run->device->dmxOut < 0){
+      continue;
+    }
+    for(i = 0; i < sizeof(out); i++){
+      out[i] = (unsigned char)(run->index * 16 + i + run->frames);
+    }
+    ret = RCUniverseWrite(handle, (unsigned int)run->device->dmxOut, 0, out, sizeof(out));
+    if(ret >= RCOk){
+      ret = RCUniverseUpdate(handle, (unsigned int)run->device->dmxOut);
+    }
+    if(ret >= RCOk && loopback){
+      ret = RCUniverseRead(handle, (unsigned int)run->device->dmxIn, 0, in, sizeof(in));
+      run->dmxChecks++;
+      if(ret >= RCOk && memcmp(in, out, sizeof(out)) != 0){
+        run->dmxErrors++;
+      }
+    }
+    if(ret < RCOk){
+      break;
+    }
+  }
+  run->elapsed = RCUClock() - start;
+  if(ret < RCOk){
+    run->error = ret;
+    return;
+  }
+
+  /* wait until the queued frames have played */
+  end = RCUClock() + (buffers + 1) * frameTime + 100000;
+  while((ret = RCWaitForReady(handle, 0)) >= RCOk && ret < buffers && RCUClock() < end){
+    RCUSleep(1000);
+  }
+  if(ret < RCOk){
+    run->error = ret;
+    return;
+  }
+  if(ret != buffers){
+    run->frameErrors++;
+  }
+  if(run->frames > 0 && RCUClock() - start < (long long)(run->frames - 1) * frameTime){
+    run->frameErrors++;
+  }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI frameThread(LPVOID arg){
+  frameRun((struct FrameRun *)arg);
+  return 0;
+}
+
+static DWORD WINAPI callThread(LPVOID arg){
+  callRun((struct CallRun *)arg);
+  return 0;
+}
+
+static DWORD WINAPI stressThread(LPVOID arg){
+  stressRun((struct StressRun *)arg);
+  return 0;
+}
+
+typedef LPTHREAD_START_ROUTINE ThreadFunction;
+#else
+static void *frameThread(void *arg){
+  frameRun((struct FrameRun *)arg);
+  return NULL;
+}
+
+static void *callThread(void *arg){
+  callRun((struct CallRun *)arg);
+  return NULL;
+}
+
+static void *stressThread(void *arg){
+  stressRun((struct StressRun *)arg);
+  return NULL;
+}
+
+typedef void *(*ThreadFunction)(void *);
+#endif
+
+/* Run function on n argument structures of size bytes in parallel. */
+static int runParallel(ThreadFunction function, void *args, size_t size, int n){
+  int i, ret = 0;
+#if defined(_WIN32)
+  HANDLE threads[MAX_DEVICES + 1];
+  for(i = 0; i < n; i++){
+    threads[i] = CreateThread(NULL, 0, function, (char *)args + i * size, 0, NULL);
+    if(threads[i] == NULL){
+      ret = -1;
+      n = i;
+      break;
+    }
+  }
+  for(i = 0; i < n; i++){
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+  }
+#else
+  pthread_t threads[MAX_DEVICES + 1];
+  for(i = 0; i < n; i++){
+    if(pthread_create(&threads[i], NULL, function, (char *)args + i * size) != 0){
+      ret = -1;
+      n = i;
+      break;
+    }
+  }
+  for(i = 0; i < n; i++){
+    pthread_join(threads[i], NULL);
+  }
+#endif
+  return ret;
+}
+
+static void printFrameRun(const char *test, int deviceTotal, const struct FrameRun *run){
+  double seconds = (double)run->steadyTime / 1e6;
+  double framesPerSecond = run->steadyTime > 0 ? (double)run->steadyFrames / seconds : 0.0;
+  printf("%s,%d,%u,%u,%.3f,%llu,%.1f,%.0f,%.1f,%.1f,%lld,%.1f,%.1f,%.1f,%d\n",
+    test, deviceTotal, run->count, run->speed, seconds, run->steadyFrames,
+    framesPerSecond, framesPerSecond * run->count,
+    run->frames ? (double)run->writeTotal / run->frames : 0.0,
+    run->frames ? (double)run->waitTotal / run->frames : 0.0,
+    run->writeMax, run->jitterSum, run->jitterSquares, run->jitterMax, run->error);
+}
+
+/* Restart the output so that every run begins with empty buffers. */
+static int restartOutput(struct Device *device){
+  int ret = RCStopOutput(device->handle);
+  if(ret < RCOk){
+    return ret;
+  }
+  return RCStartOutput(device->handle);
+}
+
+static int benchFrames(long long duration){
+  static const unsigned int sizes[] = { 10, 100, 1000, 10000 };
+  static const unsigned int speeds[] = { 10000, 30000, 0 };
+  struct FrameRun run;
+  unsigned int i, j;
+
+  memset(&run, 0, sizeof(run));
+  run.device = &devices[0];
+  run.duration = duration;
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++){
+    run.count = sizes[i];
+    run.points = (struct RCPoint *)malloc(run.count * sizeof(struct RCPoint));
+    if(run.points == NULL){
+      return -1;
+    }
+    fillCircle(run.points, run.count);
+    for(j = 0; j < sizeof(speeds) / sizeof(speeds[0]); j++){
+      /* 0 selects the maximum speed of the device */
+      run.speed = speeds[j] != 0 ? speeds[j] : (unsigned int)run.device->maxSpeed;
+      if(run.speed > (unsigned int)run.device->maxSpeed){
+        continue;
+      }
+      fprintf(stderr, "frames: %u points at %u Hz\n", run.count, run.speed);
+      if(restartOutput(run.device) < RCOk){
+        free(run.points);
+        return -1;
+      }
+      frameRun(&run);
+      printFrameRun("frames", 1, &run);
+    }
+    free(run.points);
+  }
+  return 0;
+}
+
+static int benchScaling(long long duration, int maxDevices){
+  struct FrameRun runs[MAX_DEVICES];
+  struct RCPoint points[1000];
+  int n, i;
+
+  fillCircle(points, 1000);
+  for(n = 1; n <= maxDevices; n++){
+    fprintf(stderr, "scaling: %d device(s)\n", n);
+    memset(runs, 0, sizeof(runs));
+    for(i = 0; i < n; i++){
+      runs[i].device = &devices[i];
+      runs[i].points = points;
+      runs[i].count = 1000;
+      runs[i].speed = (unsigned int)devices[i].maxSpeed;
+      runs[i].duration = duration;
+      if(restartOutput(&devices[i]) < RCOk){
+        return -1;
+      }
+    }
+    if(runParallel(frameThread, runs, sizeof(runs[0]), n) < 0){
+      return -1;
+    }
+    for(i = 0; i < n; i++){
+      printFrameRun("scaling", n, &runs[i]);
+    }
+  }
+  return 0;
+}
+
+static int benchConcurrency(long long duration, int maxDevices){
+  struct CallRun runs[MAX_DEVICES];
+  int n, i;
+
+  printf("test,devices,device,seconds,calls,calls_per_s,error\n");
+  for(n = 1; n <= maxDevices; n++){
+    fprintf(stderr, "concurrency: %d device(s)\n", n);
+    memset(runs, 0, sizeof(runs));
+    for(i = 0; i < n; i++){
+      runs[i].device = &devices[i];
+      runs[i].duration = duration;
+    }
+    if(runParallel(callThread, runs, sizeof(runs[0]), n) < 0){
+      return -1;
+    }
+    for(i = 0; i < n; i++){
+      double seconds = (double)runs[i].elapsed / 1e6;
+      printf("concurrency,%d,%d,%.3f,%llu,%.0f,%d\n", n, i, seconds, runs[i].calls,
+        (double)runs[i].calls / seconds, runs[i].error);
+    }
+  }
+  return 0;
+}
+
+/* Returns the number of failed checks, or -1 if the test could not run. */
+static int benchStress(long long duration){
+  struct StressRun runs[MAX_DEVICES + 1];
+  int i, failures = 0;
+
+  fprintf(stderr, "stress: %d device(s) and enumeration\n", deviceCount);
+  memset(runs, 0, sizeof(runs));
+  for(i = 0; i <= deviceCount; i++){
+    runs[i].device = i < deviceCount ? &devices[i] : NULL;
+    runs[i].index = (unsigned int)i;
+    runs[i].duration = duration;
+    if(i < deviceCount && restartOutput(&devices[i]) < RCOk){
+      return -1;
+    }
+  }
+  if(runParallel(stressThread, runs, sizeof(runs[0]), deviceCount + 1) < 0){
+    return -1;
+  }
+  printf("test,device,seconds,frames,frame_errors,dmx_checks,dmx_errors,enumerations,error\n");
+  for(i = 0; i <= deviceCount; i++){
+    printf("stress,%d,%.3f,%llu,%llu,%llu,%llu,%llu,%d\n",
+      i < deviceCount ? i : -1, (double)runs[i].elapsed / 1e6, runs[i].frames,
+      runs[i].frameErrors, runs[i].dmxChecks, runs[i].dmxErrors, runs[i].enumerations, runs[i].error);
+    if(runs[i].frameErrors > 0 || runs[i].dmxErrors > 0 || runs[i].error != RCOk){
+      failures++;
+    }
+  }
+  return failures;
+}
+
+static int benchUniverses(long long duration){
+  unsigned char data[512];
+  int d;
+
+  memset(data, 0x55, sizeof(data));
+  printf("test,device,universe,channels,seconds,updates,updates_per_s,channels_per_s,update_us_avg,error\n");
+  for(d = 0; d < deviceCount; d++){
+    int handle = devices[d].handle;
+    int count = RCUniverseCount(handle);
+    int u;
+    for(u = 0; u < count; u++){
+      enum RCUniverseDirection direction;
+      unsigned int channels;
+      unsigned long long calls = 0;
+      long long start, elapsed;
+      int ret = RCUniverseQuery(handle, (unsigned int)u, NULL, 0, &direction, &channels);
+      if(ret < RCOk || direction != RCOutput){
+        continue;
+      }
+      if(channels > sizeof(data)){
+        channels = sizeof(data);
+      }
+      fprintf(stderr, "universes: device %d universe %d\n", d, u);
+      start = RCUClock();
+      do{
+        ret = RCUniverseWrite(handle, (unsigned int)u, 0, data, channels);
+        if(ret >= RCOk){
+          ret = RCUniverseUpdate(handle, (unsigned int)u);
+        }
+        if(ret < RCOk){
+          break;
+        }
+        calls++;
+        elapsed = RCUClock() - start;
+      } while(elapsed < duration);
+      elapsed = RCUClock() - start;
+      printf("universes,%d,%d,%u,%.3f,%llu,%.1f,%.0f,%.1f,%d\n",
+        d, u, channels, (double)elapsed / 1e6, calls,
+        (double)calls / ((double)elapsed / 1e6), (double)calls * channels / ((double)elapsed / 1e6),
+        calls ? (double)elapsed / calls : 0.0, ret < RCOk ? ret : RCOk);
+    }
+  }
+  return 0;
+}
+
+static void findUniverses(struct Device *device){
+  int count = RCUniverseCount(device->handle), u;
+  device->dmxOut = device->dmxIn = -1;
+  for(u = 0; u < count; u++){
+    enum RCUniverseDirection direction;
+    unsigned int channels;
+    if(RCUniverseQuery(device->handle, (unsigned int)u, NULL, 0, &direction, &channels) < RCOk){
+      continue;
+    }
+    if(direction == RCOutput && device->dmxOut < 0){
+      device->dmxOut = u;
+    } else if(direction == RCInput && device->dmxIn < 0){
+      device->dmxIn = u;
+    }
+  }
+}
+
+int main(int argc, char *argv[]){
+  long long duration = 1000000;
+  int maxDevices = MAX_DEVICES;
+  int i, ret, count, stressFailed = 0;
+  char deviceId[256];
+
+  if(argc > 1){
+    duration = atoi(argv[1]) * 1000LL;
+  }
+  if(argc > 2){
+    maxDevices = atoi(argv[2]);
+  }
+  if(duration <= 0 || maxDevices < 1){
+    fprintf(stderr, "Usage: %s [duration in ms per test] [maximum number of devices]\n", argv[0]);
+    return -1;
+  }
+
+  ret = RCInit();
+  if(ret < RCAPI_VERSION){
+    fprintf(stderr, "Error initialising library: %d\n", ret); return -1;
+  }
+  count = RCEnumerateDevices();
+  if(count <= 0){
+    fprintf(stderr, "No devices found: %d\n", count); return -1;
+  }
+  if(count > maxDevices){
+    count = maxDevices;
+  }
+  for(i = 0; i < count; i++){
+    ret = RCDeviceID((unsigned int)i, deviceId, sizeof(deviceId));
+    if(ret < RCOk){
+      fprintf(stderr, "Error reading device id: %d\n", ret); return -1;
+    }
+    devices[i].handle = RCOpenDevice(deviceId);
+    if(devices[i].handle < RCOk){
+      fprintf(stderr, "Error opening %s: %d\n", deviceId, devices[i].handle); return -1;
+    }
+    findUniverses(&devices[i]);
+    devices[i].maxSpeed = RCMaxSpeed(devices[i].handle);
+    if(devices[i].maxSpeed <= 0){
+      fprintf(stderr, "Error reading maximum speed of %s: %d\n", deviceId, devices[i].maxSpeed); return -1;
+    }
+    ret = RCStartOutput(devices[i].handle);
+    if(ret < RCOk){
+      fprintf(stderr, "Error starting %s: %d\n", deviceId, ret); return -1;
+    }
+    fprintf(stderr, "Device %d: %s, %d Hz\n", i, deviceId, devices[i].maxSpeed);
+    deviceCount++;
+  }
+
+  printf("test,devices,points,speed,seconds,frames,frames_per_s,points_per_s,"
+         "write_us_avg,wait_us_avg,write_us_max,jitter_us_avg,jitter_us_rms,jitter_us_max,error\n");
+  ret = benchFrames(duration);
+  if(ret >= 0){
+    ret = benchScaling(duration, deviceCount);
+  }
+  if(ret >= 0){
+    ret = benchConcurrency(duration, deviceCount);
+  }
+  if(ret >= 0){
+    ret = benchStress(duration);
+    if(ret > 0){
+      fprintf(stderr, "stress: %d thread(s) failed\n", ret);
+      stressFailed = 1;
+    }
+  }
+  if(ret >= 0){
+    ret = benchUniverses(duration);
+  }
+
+  for(i = 0; i < deviceCount; i++){
+    RCStopOutput(devices[i].handle);
+    RCCloseDevice(devices[i].handle);
+  }
+  RCExit();
+  if(ret < 0){
+    return -2;
+  }
+  return stressFailed ? -3 : 0;
+}
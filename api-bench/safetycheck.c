@@ -0,0 +1,136 @@
+/* safetycheck.c - regression checks for the safety zones of api-util
+ *
+ * Runs RCUSafetyApply() on fixed frames and checks which points are
+ * blanked. No device is needed. Prints one line per failed check on stderr
+ * and a summary on stdout.
+ *
+ * Usage: safetycheck
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "rcdev.h"
+#include "rcutil.h"
+
+/* Exposure window of all checks; long enough not to roll over while running */
+#define WINDOW 10000000
+
+static int failures;
+
+static void check(int condition, const char *name){
+  if(!condition){
+    fprintf(stderr, "FAILED: %s\n", name);
+    failures++;
+  }
+}
+
+static void setPoint(struct RCPoint *point, signed short x, signed short y, unsigned short red, unsigned short user1){
+  memset(point, 0, sizeof(*point));
+  point->x = x;
+  point->y = y;
+  point->red = red;
+  point->user1 = user1;
+}
+
+static int blanked(const struct RCPoint *point){
+  return (point->red | point->green | point->blue | point->intensity | point->user1 | point->user2) == 0;
+}
+
+/* Square from -1000 to 1000 around the origin */
+static const signed short squareX[4] = {-1000, 1000, 1000, -1000};
+static const signed short squareY[4] = {-1000, -1000, 1000, 1000};
+
+static void initZone(struct RCUSafety *safety, enum RCUZoneType type, unsigned int budget){
+  RCUSafetyInit(safety, -1, WINDOW);
+  RCUSafetyAddZone(safety, type, squareX, squareY, 4, budget);
+}
+
+static void checkForbiddenPoints(void){
+  struct RCUSafety safety;
+  struct RCPoint points[3];
+  initZone(&safety, RCUZoneForbidden, 0);
+  /* lit through red only, intensity 0 */
+  setPoint(&points[0], 0, 0, 65535, 0);
+  /* lit through user1 only */
+  setPoint(&points[1], 500, 500, 0, 1);
+  /* outside, but the lit line from the previous point leaves the zone */
+  setPoint(&points[2], 20000, 0, 65535, 0);
+  check(RCUSafetyApply(&safety, points, points, 3, 30000, 1) == RCOk, "forbidden points: apply");
+  check(blanked(&points[0]), "forbidden points: red with intensity 0 inside is blanked");
+  check(blanked(&points[1]), "forbidden points: user1 only inside is blanked");
+  check(blanked(&points[2]), "forbidden points: end of a lit line leaving the zone is blanked");
+}
+
+static void checkForbiddenCrossing(void){
+  struct RCUSafety safety;
+  struct RCPoint points[4];
+  initZone(&safety, RCUZoneForbidden, 0);
+  /* lit line from left to right through the zone */
+  setPoint(&points[0], -5000, 0, 65535, 0);
+  setPoint(&points[1], 5000, 0, 65535, 0);
+  /* lit line beside the zone */
+  setPoint(&points[2], 5000, 5000, 65535, 0);
+  setPoint(&points[3], -5000, 5000, 65535, 0);
+  check(RCUSafetyApply(&safety, points, points, 4, 30000, 1) == RCOk, "forbidden crossing: apply");
+  check(blanked(&points[0]) && blanked(&points[1]), "forbidden crossing: ends of the crossing line are blanked");
+  check(points[2].red == 65535 && points[3].red == 65535, "forbidden crossing: line beside the zone is kept");
+}
+
+static void checkForbiddenClosingLine(void){
+  struct RCUSafety safety;
+  struct RCPoint points[3];
+  initZone(&safety, RCUZoneForbidden, 0);
+  /* only the line from the last point back to the first crosses the zone */
+  setPoint(&points[0], -5000, -100, 65535, 0);
+  setPoint(&points[1], 0, -20000, 65535, 0);
+  setPoint(&points[2], 5000, 100, 65535, 0);
+  check(RCUSafetyApply(&safety, points, points, 3, 30000, 1) == RCOk, "closing line: apply");
+  check(blanked(&points[0]) && blanked(&points[2]), "closing line: ends of the closing line are blanked");
+  check(points[1].red == 65535, "closing line: other point is kept");
+  check(safety.zones[0].blanked == 2, "closing line: blanked count");
+}
+
+static void checkBudget(void){
+  struct RCUSafety safety;
+  struct RCPoint points[2];
+  unsigned int i;
+  /* 10 kHz: every pass of a point takes 100 us; the budget allows 3 */
+  initZone(&safety, RCUZoneLimited, 300);
+  for(i = 0; i < 3; i++){
+    setPoint(&points[0], 0, 0, 65535, 0);
+    setPoint(&points[1], 20000, 0, 65535, 0);
+    check(RCUSafetyApply(&safety, points, points, 2, 10000, 1) == RCOk, "budget: apply");
+    check(points[0].red == 65535, "budget: point inside is kept within the budget");
+  }
+  setPoint(&points[0], 0, 0, 65535, 0);
+  setPoint(&points[1], 20000, 0, 65535, 0);
+  check(RCUSafetyApply(&safety, points, points, 2, 10000, 1) == RCOk, "budget: apply");
+  check(blanked(&points[0]), "budget: point inside is blanked once the budget is used up");
+  check(points[1].red == 65535, "budget: point outside is kept");
+  check(safety.zones[0].exposure == 300000, "budget: exposure");
+}
+
+static void checkRepeatForever(void){
+  struct RCUSafety safety;
+  struct RCPoint point;
+  /* one point at the highest speed, repeated for the whole 10 s window,
+   * against a 1 s budget */
+  initZone(&safety, RCUZoneLimited, 1000000);
+  setPoint(&point, 0, 0, 65535, 0);
+  check(RCUSafetyApply(&safety, &point, &point, 1, 1000000000u, 0) == RCOk, "repeat 0: apply");
+  check(blanked(&point), "repeat 0: point inside is blanked");
+  check(safety.zones[0].exposure >= 0 && safety.zones[0].exposure <= safety.zones[0].budget, "repeat 0: exposure within the budget");
+  check(RCUSafetyApply(&safety, &point, &point, 1, 0, 0) == RCErrorParameterOutOfRange, "speed 0 is rejected");
+  check(RCUSafetyApply(&safety, &point, &point, 1, 1000000001u, 0) == RCErrorParameterOutOfRange, "speed above 1 GHz is rejected");
+}
+
+int main(void){
+  checkForbiddenPoints();
+  checkForbiddenCrossing();
+  checkForbiddenClosingLine();
+  checkBudget();
+  checkRepeatForever();
+  printf("safetycheck: %d failed\n", failures);
+  return failures == 0 ? 0 : -1;
+}
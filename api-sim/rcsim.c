@@ -0,0 +1,713 @@
+/* rcsim.c - software stand-in for the RayComposer device library
+ *
+ * Implements the API declared in rcdev.h without any hardware. The virtual
+ * devices consume the written frames in real time at the requested sampling
+ * rate, so frame producers can be tested and profiled on machines without a
+ * RayComposer USB or NET device attached.
+ *
+ * Calls on different device handles may run in parallel from different
+ * threads; they only lock the state of their own device.
+ *
+ * Link against this library instead of the RayComposer library to opt in.
+ * See README in this directory for build instructions and configuration.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#define RCAPI_BUILD
+#include "rcdev.h"
+
+/** Maximum number of virtual devices */
+#define SIM_MAX_DEVICES 16
+/** Default number of frame buffers per device */
+#define SIM_BUFFER_COUNT 3
+/** Maximum number of frame buffers per device */
+#define SIM_MAX_BUFFERS 16
+/** Maximum sampling rate in Hz */
+#define SIM_MAX_SPEED 100000
+/** Maximum number of points per frame */
+#define SIM_MAX_POINTS 65535
+/** Channels per DMX universe */
+#define SIM_CHANNELS 512
+/** Maximum length of the device label including terminating nul character */
+#define SIM_LABEL_LENGTH 64
+
+#if defined(_WIN32)
+typedef SRWLOCK SimMutex;
+#define SIM_MUTEX_INITIALIZER SRWLOCK_INIT
+#define simMutexInit(m) InitializeSRWLock(m)
+#define simMutexLock(m) AcquireSRWLockExclusive(m)
+#define simMutexUnlock(m) ReleaseSRWLockExclusive(m)
+#else
+typedef pthread_mutex_t SimMutex;
+#define SIM_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define simMutexInit(m) pthread_mutex_init(m, NULL)
+#define simMutexLock(m) pthread_mutex_lock(m)
+#define simMutexUnlock(m) pthread_mutex_unlock(m)
+#endif
+
+/** Universe indices; the output universe is looped back to the input universe */
+enum SimUniverse {
+  SimUniverseOutput = 0,
+  SimUniverseInput = 1,
+  SimUniverseCount = 2
+};
+
+struct SimFrame {
+  struct RCPoint *points;
+  unsigned int capacity;
+  unsigned int count;
+  unsigned int speed;
+  unsigned int repeat;
+  /* time the frame was written in ns */
+  long long queuedAt;
+};
+
+struct SimDevice {
+  /* protects all other members */
+  SimMutex mutex;
+  char id[32];
+  char label[SIM_LABEL_LENGTH];
+  int open;
+  int started;
+  /* ring of queued frames; the head frame is the one playing */
+  struct SimFrame frames[SIM_MAX_BUFFERS];
+  unsigned int bufferCount;
+  unsigned int head;
+  unsigned int queued;
+  /* completed passes of the head frame and start time of the current pass in ns */
+  unsigned int passes;
+  long long passStart;
+  FILE *dump;
+  /* written but not yet flushed DMX output, flushed output looped back to the input */
+  unsigned char dmxPending[SIM_CHANNELS];
+  unsigned char dmxLive[SIM_CHANNELS];
+};
+
+/* Device calls only lock the device mutex; the global mutex serialises
+ * RCInit(), RCExit(), RCEnumerateDevices(), RCDeviceID() and RCOpenDevice(). */
+static SimMutex simGlobalMutex = SIM_MUTEX_INITIALIZER;
+static int simMutexesReady;
+static int simInitialised;
+static int simEnumerated;
+static int simVerbose;
+static unsigned int simDeviceCount;
+static struct SimDevice simDevices[SIM_MAX_DEVICES];
+
+
+/* Monotonic time in nanoseconds. */
+static long long simNow(void){
+#if defined(_WIN32)
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (long long)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+static void simSleep(long long ns){
+#if defined(_WIN32)
+  Sleep((DWORD)((ns + 999999) / 1000000));
+#else
+  struct timespec ts;
+  ts.tv_sec = (time_t)(ns / 1000000000LL);
+  ts.tv_nsec = (long)(ns % 1000000000LL);
+  nanosleep(&ts, NULL);
+#endif
+}
+
+/* Copy a string the way RCDeviceID() documents it: at most maxLength bytes
+ * including the terminating nul character, or only report the required
+ * length if maxLength is 0. */
+static int simCopyString(char *dst, const char *src, unsigned int maxLength){
+  unsigned int length = (unsigned int)strlen(src) + 1;
+  if(maxLength == 0){
+    return (int)length;
+  }
+  if(dst == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(length > maxLength){
+    length = maxLength;
+  }
+  memcpy(dst, src, length - 1);
+  dst[length - 1] = '\0';
+  return (int)length;
+}
+
+static int simEnvInt(const char *name, int defaultValue){
+  const char *value = getenv(name);
+  if(value == NULL || *value == '\0'){
+    return defaultValue;
+  }
+  return atoi(value);
+}
+
+/* Look up and lock the device of an open handle. Handles index a fixed
+ * array, so no global lock is needed. A device is only open between
+ * RCEnumerateDevices() and RCExit(), so the global state is consulted, under
+ * the global lock, only to report why a handle is not open.
+ * simMutexesReady is set once by RCInit(), before any handle can exist. */
+static int simLock(int handle, struct SimDevice **pDevice){
+  struct SimDevice *dev;
+  int ret;
+  if(!simMutexesReady){
+    return RCErrorNotInitialised;
+  }
+  if(handle < 1 || handle > SIM_MAX_DEVICES){
+    ret = RCErrorInvalidHandle;
+  } else {
+    dev = &simDevices[handle - 1];
+    simMutexLock(&dev->mutex);
+    if(dev->open){
+      *pDevice = dev;
+      return RCOk;
+    }
+    simMutexUnlock(&dev->mutex);
+    ret = RCErrorInvalidHandle;
+  }
+  simMutexLock(&simGlobalMutex);
+  if(!simInitialised){
+    ret = RCErrorNotInitialised;
+  } else if(!simEnumerated){
+    ret = RCErrorNotEnumerated;
+  }
+  simMutexUnlock(&simGlobalMutex);
+  return ret;
+}
+
+static long long simDuration(const struct SimFrame *frame){
+  return (long long)frame->count * 1000000000LL / frame->speed;
+}
+
+/* Number of passes the head frame still plays before its buffer is
+ * released, or -1 if it repeats until a new frame is written. */
+static long long simRemainingPasses(const struct SimDevice *dev){
+  const struct SimFrame *frame = &dev->frames[dev->head];
+  const struct SimFrame *next;
+  long long duration, remaining;
+
+  if(frame->repeat != 0){
+    return (long long)frame->repeat - dev->passes;
+  }
+  if(dev->queued < 2){
+    return -1;
+  }
+  /* A continuously repeated frame is replaced at the end of the first pass
+   * that ends after the next frame has been written. */
+  next = &dev->frames[(dev->head + 1) % dev->bufferCount];
+  duration = simDuration(frame);
+  remaining = (next->queuedAt - dev->passStart + duration - 1) / duration;
+  if(remaining < 0){
+    remaining = 0;
+  }
+  if(remaining == 0 && dev->passes == 0){
+    remaining = 1;
+  }
+  return remaining;
+}
+
+static void simDump(struct SimDevice *dev, const struct SimFrame *frame, long long passes){
+  if(dev->dump == NULL){
+    return;
+  }
+  while(passes-- > 0){
+    fwrite(frame->points, sizeof(struct RCPoint), frame->count, dev->dump);
+  }
+}
+
+/* Play out the queued frames up to the time now. */
+static void simAdvance(struct SimDevice *dev, long long now){
+  while(dev->queued > 0){
+    struct SimFrame *frame = &dev->frames[dev->head];
+    long long duration = simDuration(frame);
+    long long remaining = simRemainingPasses(dev);
+
+    if(remaining != 0){
+      long long passes = (now - dev->passStart) / duration;
+      if(remaining > 0 && passes > remaining){
+        passes = remaining;
+      }
+      if(passes <= 0){
+        return;
+      }
+      simDump(dev, frame, passes);
+      dev->passStart += passes * duration;
+      dev->passes += (unsigned int)passes;
+      if(remaining < 0 || passes < remaining){
+        return;
+      }
+    }
+
+    /* The head frame is done; release its buffer. */
+    dev->head = (dev->head + 1) % dev->bufferCount;
+    dev->queued--;
+    dev->passes = 0;
+    if(dev->queued > 0){
+      frame = &dev->frames[dev->head];
+      if(frame->queuedAt > dev->passStart){
+        if(simVerbose){
+          fprintf(stderr, "rcsim: %s: buffer underrun\n", dev->id);
+        }
+        dev->passStart = frame->queuedAt;
+      }
+    } else if(simVerbose && frame->repeat != 0){
+      fprintf(stderr, "rcsim: %s: buffer underrun\n", dev->id);
+    }
+  }
+}
+
+/* Time in ns when the head frame releases its buffer, or -1 if unknown. */
+static long long simReleaseTime(const struct SimDevice *dev){
+  long long remaining = simRemainingPasses(dev);
+  if(remaining < 0){
+    return -1;
+  }
+  return dev->passStart + remaining * simDuration(&dev->frames[dev->head]);
+}
+
+static void simClear(struct SimDevice *dev){
+  dev->head = 0;
+  dev->queued = 0;
+  dev->passes = 0;
+}
+
+static void simClose(struct SimDevice *dev){
+  unsigned int i;
+  simClear(dev);
+  for(i = 0; i < SIM_MAX_BUFFERS; i++){
+    free(dev->frames[i].points);
+    dev->frames[i].points = NULL;
+    dev->frames[i].capacity = 0;
+  }
+  if(dev->dump != NULL){
+    fclose(dev->dump);
+    dev->dump = NULL;
+  }
+  dev->started = 0;
+  dev->open = 0;
+}
+
+
+int RCAPI RCInit(){
+  simMutexLock(&simGlobalMutex);
+  if(!simMutexesReady){
+    unsigned int i;
+    for(i = 0; i < SIM_MAX_DEVICES; i++){
+      simMutexInit(&simDevices[i].mutex);
+    }
+    simMutexesReady = 1;
+  }
+  if(!simInitialised){
+    simDeviceCount = 0;
+    simEnumerated = 0;
+    simVerbose = simEnvInt("RCSIM_VERBOSE", 0);
+    simInitialised = 1;
+  }
+  simMutexUnlock(&simGlobalMutex);
+  return RCAPI_VERSION;
+}
+
+int RCAPI RCExit(){
+  unsigned int i;
+  simMutexLock(&simGlobalMutex);
+  if(!simInitialised){
+    simMutexUnlock(&simGlobalMutex);
+    return RCErrorNotInitialised;
+  }
+  for(i = 0; i < SIM_MAX_DEVICES; i++){
+    struct SimDevice *dev = &simDevices[i];
+    simMutexLock(&dev->mutex);
+    if(dev->open){
+      simClose(dev);
+    }
+    simMutexUnlock(&dev->mutex);
+  }
+  simEnumerated = 0;
+  simInitialised = 0;
+  simMutexUnlock(&simGlobalMutex);
+  return RCOk;
+}
+
+int RCAPI RCEnumerateDevices(){
+  int count;
+  unsigned int i;
+  simMutexLock(&simGlobalMutex);
+  if(!simInitialised){
+    simMutexUnlock(&simGlobalMutex);
+    return RCErrorNotInitialised;
+  }
+  count = simEnvInt("RCSIM_DEVICES", 1);
+  if(count < 0){
+    count = 0;
+  }
+  if(count > SIM_MAX_DEVICES){
+    count = SIM_MAX_DEVICES;
+  }
+  for(i = 0; i < (unsigned int)count; i++){
+    struct SimDevice *dev = &simDevices[i];
+    simMutexLock(&dev->mutex);
+    if(!dev->open){
+      sprintf(dev->id, "RayComposer Virtual %u", i);
+      sprintf(dev->label, "Virtual %u", i);
+    }
+    simMutexUnlock(&dev->mutex);
+  }
+  simDeviceCount = (unsigned int)count;
+  simEnumerated = 1;
+  simMutexUnlock(&simGlobalMutex);
+  return count;
+}
+
+int RCAPI RCDeviceID(unsigned int index, char *deviceId, unsigned int maxLength){
+  int ret;
+  simMutexLock(&simGlobalMutex);
+  if(!simInitialised){
+    ret = RCErrorNotInitialised;
+  } else if(!simEnumerated){
+    ret = RCErrorNotEnumerated;
+  } else if(index >= simDeviceCount){
+    ret = RCErrorParameterOutOfRange;
+  } else {
+    ret = simCopyString(deviceId, simDevices[index].id, maxLength);
+  }
+  simMutexUnlock(&simGlobalMutex);
+  return ret;
+}
+
+/* Open the device; called with the global and the device mutex locked. */
+static int simOpen(struct SimDevice *dev, unsigned int index){
+  const char *dumpPath;
+  int buffers;
+  if(dev->open){
+    return RCErrorParameterInvalid;
+  }
+  simClear(dev);
+  /* a continuously repeated frame is only replaced by a queued one, so at
+   * least two buffers are needed */
+  buffers = simEnvInt("RCSIM_BUFFERS", SIM_BUFFER_COUNT);
+  if(buffers < 2){
+    buffers = 2;
+  } else if(buffers > SIM_MAX_BUFFERS){
+    buffers = SIM_MAX_BUFFERS;
+  }
+  dev->bufferCount = (unsigned int)buffers;
+  memset(dev->dmxPending, 0, sizeof(dev->dmxPending));
+  memset(dev->dmxLive, 0, sizeof(dev->dmxLive));
+  dumpPath = getenv("RCSIM_DUMP");
+  if(dumpPath != NULL && *dumpPath != '\0'){
+    if(simDeviceCount > 1){
+      char path[1024];
+      if(strlen(dumpPath) + 12 > sizeof(path)){
+        return RCErrorParameterInvalid;
+      }
+      sprintf(path, "%s.%u", dumpPath, index);
+      dev->dump = fopen(path, "wb");
+    } else {
+      dev->dump = fopen(dumpPath, "wb");
+    }
+    if(dev->dump == NULL){
+      return RCErrorIO;
+    }
+  }
+  dev->open = 1;
+  return (int)index + 1;
+}
+
+int RCAPI RCOpenDevice(const char *deviceId){
+  unsigned int i;
+  int ret = RCErrorParameterInvalid;
+  simMutexLock(&simGlobalMutex);
+  if(!simInitialised){
+    ret = RCErrorNotInitialised;
+  } else if(!simEnumerated){
+    ret = RCErrorNotEnumerated;
+  } else if(deviceId != NULL){
+    for(i = 0; i < simDeviceCount; i++){
+      struct SimDevice *dev = &simDevices[i];
+      if(strcmp(dev->id, deviceId) == 0){
+        simMutexLock(&dev->mutex);
+        ret = simOpen(dev, i);
+        simMutexUnlock(&dev->mutex);
+        break;
+      }
+    }
+  }
+  simMutexUnlock(&simGlobalMutex);
+  return ret;
+}
+
+int RCAPI RCCloseDevice(int handle){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  simClose(dev);
+  simMutexUnlock(&dev->mutex);
+  return RCOk;
+}
+
+int RCAPI RCDeviceLabel(int handle, char *deviceLabel, unsigned int maxLength){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  ret = simCopyString(deviceLabel, dev->label, maxLength);
+  simMutexUnlock(&dev->mutex);
+  return ret;
+}
+
+int RCAPI RCSetDeviceLabel(int handle, const char *deviceLabel){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  if(deviceLabel == NULL){
+    ret = RCErrorParameterInvalid;
+  } else if(strlen(deviceLabel) >= SIM_LABEL_LENGTH){
+    ret = RCErrorParameterOutOfRange;
+  } else {
+    strcpy(dev->label, deviceLabel);
+  }
+  simMutexUnlock(&dev->mutex);
+  return ret;
+}
+
+int RCAPI RCStartOutput(int handle){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  simClear(dev);
+  dev->started = 1;
+  simMutexUnlock(&dev->mutex);
+  return RCOk;
+}
+
+int RCAPI RCStopOutput(int handle){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  simAdvance(dev, simNow());
+  simClear(dev);
+  dev->started = 0;
+  simMutexUnlock(&dev->mutex);
+  return RCOk;
+}
+
+/* Wait for a free buffer; called with the device mutex locked, which is
+ * released while sleeping. */
+static int simWaitForReady(struct SimDevice *dev, int timeout){
+  long long now, deadline = 0;
+  now = simNow();
+  if(timeout > 0){
+    deadline = now + (long long)timeout * 1000000LL;
+  }
+  for(;;){
+    long long wake;
+    if(!dev->open){
+      return RCErrorInvalidHandle;
+    }
+    if(!dev->started){
+      return RCErrorNotStarted;
+    }
+    simAdvance(dev, now);
+    if(dev->queued < dev->bufferCount || timeout == 0 || (timeout > 0 && now >= deadline)){
+      return (int)dev->bufferCount - (int)dev->queued;
+    }
+    wake = simReleaseTime(dev);
+    if(wake < 0){
+      /* not reached with more than one buffer; poll to be safe */
+      wake = now + 1000000LL;
+    }
+    if(timeout > 0 && wake > deadline){
+      wake = deadline;
+    }
+    if(wake > now){
+      simMutexUnlock(&dev->mutex);
+      simSleep(wake - now);
+      simMutexLock(&dev->mutex);
+    }
+    now = simNow();
+  }
+}
+
+int RCAPI RCWaitForReady(int handle, int timeout){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  ret = simWaitForReady(dev, timeout);
+  simMutexUnlock(&dev->mutex);
+  return ret;
+}
+
+int RCAPI RCMaxSpeed(int handle){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  simMutexUnlock(&dev->mutex);
+  return SIM_MAX_SPEED;
+}
+
+/* Queue a frame; called with the device mutex locked. */
+static int simWriteFrame(struct SimDevice *dev, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat){
+  struct SimFrame *frame;
+  long long now;
+  int ret;
+  if(!dev->started){
+    return RCErrorNotStarted;
+  }
+  if(points == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(count == 0 || count > SIM_MAX_POINTS || speed == 0 || speed > SIM_MAX_SPEED){
+    return RCErrorParameterOutOfRange;
+  }
+
+  /* Like the hardware, block until a buffer is free. */
+  ret = simWaitForReady(dev, -1);
+  if(ret < RCOk){
+    return ret;
+  }
+  now = simNow();
+  simAdvance(dev, now);
+
+  frame = &dev->frames[(dev->head + dev->queued) % dev->bufferCount];
+  if(frame->capacity < count){
+    struct RCPoint *buffer = (struct RCPoint *)realloc(frame->points, count * sizeof(struct RCPoint));
+    if(buffer == NULL){
+      return RCErrorIO;
+    }
+    frame->points = buffer;
+    frame->capacity = count;
+  }
+  memcpy(frame->points, points, count * sizeof(struct RCPoint));
+  frame->count = count;
+  frame->speed = speed;
+  frame->repeat = repeat;
+  frame->queuedAt = now;
+  if(dev->queued == 0){
+    dev->passStart = now;
+    dev->passes = 0;
+  }
+  dev->queued++;
+  return RCOk;
+}
+
+int RCAPI RCWriteFrame(int handle, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  ret = simWriteFrame(dev, points, count, speed, repeat);
+  simMutexUnlock(&dev->mutex);
+  return ret;
+}
+
+int RCAPI RCUniverseCount(int handle){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  simMutexUnlock(&dev->mutex);
+  return SimUniverseCount;
+}
+
+int RCAPI RCUniverseQuery(int handle, unsigned int universeIndex, char *universeName, unsigned int maxLength, enum RCUniverseDirection *pUniverseDirection, unsigned int *pChannelCount){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  simMutexUnlock(&dev->mutex);
+  if(universeIndex >= SimUniverseCount){
+    return RCErrorParameterOutOfRange;
+  }
+  if(pUniverseDirection != NULL){
+    *pUniverseDirection = universeIndex == SimUniverseOutput ? RCOutput : RCInput;
+  }
+  if(pChannelCount != NULL){
+    *pChannelCount = SIM_CHANNELS;
+  }
+  return simCopyString(universeName, universeIndex == SimUniverseOutput ? "DMX Output" : "DMX Input", maxLength);
+}
+
+int RCAPI RCUniverseWrite(int handle, unsigned int universeIndex, unsigned int startChannel, const unsigned char *data, unsigned int count){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  if(universeIndex >= SimUniverseCount || startChannel > SIM_CHANNELS || count > SIM_CHANNELS - startChannel){
+    ret = RCErrorParameterOutOfRange;
+  } else if(universeIndex != SimUniverseOutput || data == NULL){
+    ret = RCErrorParameterInvalid;
+  } else {
+    memcpy(dev->dmxPending + startChannel, data, count);
+  }
+  simMutexUnlock(&dev->mutex);
+  return ret;
+}
+
+int RCAPI RCUniverseRead(int handle, unsigned int universeIndex, unsigned int startChannel, unsigned char *data, unsigned int count){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  if(universeIndex >= SimUniverseCount || startChannel > SIM_CHANNELS || count > SIM_CHANNELS - startChannel){
+    ret = RCErrorParameterOutOfRange;
+  } else if(universeIndex != SimUniverseInput || data == NULL){
+    ret = RCErrorParameterInvalid;
+  } else {
+    memcpy(data, dev->dmxLive + startChannel, count);
+  }
+  simMutexUnlock(&dev->mutex);
+  return ret;
+}
+
+int RCAPI RCUniverseUpdate(int handle, unsigned int universeIndex){
+  struct SimDevice *dev;
+  int ret = simLock(handle, &dev);
+  if(ret < RCOk){
+    return ret;
+  }
+  if(universeIndex >= SimUniverseCount){
+    ret = RCErrorParameterOutOfRange;
+  } else if(universeIndex != SimUniverseOutput){
+    ret = RCErrorParameterInvalid;
+  } else {
+    memcpy(dev->dmxLive, dev->dmxPending, SIM_CHANNELS);
+  }
+  simMutexUnlock(&dev->mutex);
+  return ret;
+}
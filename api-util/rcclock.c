@@ -0,0 +1,37 @@
+/* rcclock.c - monotonic clock and sleep */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "rcutil.h"
+
+long long RCUClock(void){
+#if defined(_WIN32)
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (long long)((double)counter.QuadPart * 1e6 / (double)frequency.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+#endif
+}
+
+void RCUSleep(unsigned int microseconds){
+#if defined(_WIN32)
+  Sleep((microseconds + 999) / 1000);
+#else
+  struct timespec ts;
+  ts.tv_sec = (time_t)(microseconds / 1000000);
+  ts.tv_nsec = (long)(microseconds % 1000000) * 1000;
+  nanosleep(&ts, NULL);
+#endif
+}
@@ -0,0 +1,160 @@
+/* rccorrect.c - geometry and color correction */
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "rcutil.h"
+
+void RCUCorrectionInit(struct RCUCorrection *correction){
+  static const float identity[9] = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+  unsigned int c, i;
+  memcpy(correction->matrix, identity, sizeof(identity));
+  correction->affine = 1;
+  for(c = 0; c < RCUChannelCount; c++){
+    for(i = 0; i < RCU_LUT_SIZE; i++){
+      correction->luts[c][i] = (unsigned short)(i * 257);
+    }
+  }
+}
+
+int RCUCorrectionSetTransform(struct RCUCorrection *correction, const float matrix[9]){
+  if(correction == NULL || matrix == NULL){
+    return RCErrorParameterInvalid;
+  }
+  memcpy(correction->matrix, matrix, sizeof(correction->matrix));
+  correction->affine = matrix[6] == 0.0f && matrix[7] == 0.0f && matrix[8] == 1.0f;
+  return RCOk;
+}
+
+int RCUCorrectionSetLUT(struct RCUCorrection *correction, enum RCUColorChannel channel, const unsigned short table[RCU_LUT_SIZE]){
+  if(correction == NULL || table == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if((unsigned int)channel >= RCUChannelCount){
+    return RCErrorParameterOutOfRange;
+  }
+  memcpy(correction->luts[channel], table, sizeof(correction->luts[channel]));
+  return RCOk;
+}
+
+int RCUCorrectionSetGamma(struct RCUCorrection *correction, enum RCUColorChannel channel, double gamma, double scale){
+  unsigned short table[RCU_LUT_SIZE];
+  unsigned int i;
+  if(gamma <= 0.0 || scale < 0.0 || scale > 1.0){
+    return RCErrorParameterOutOfRange;
+  }
+  for(i = 0; i < RCU_LUT_SIZE; i++){
+    double input = (double)i / (RCU_LUT_SIZE - 1);
+    table[i] = (unsigned short)(scale * 65535.0 * pow(input, gamma) + 0.5);
+  }
+  return RCUCorrectionSetLUT(correction, channel, table);
+}
+
+/* Round and clamp a coordinate in the range -1 to 1 to the signal range.
+ * Written with selects only, so the loops calling it stay vectorizable. */
+static signed short correctCoordinate(float value){
+  value *= 32768.0f;
+  value += value >= 0.0f ? 0.5f : -0.5f;
+  value = value > 32767.0f ? 32767.0f : value;
+  value = value < -32768.0f ? -32768.0f : value;
+  return (signed short)value;
+}
+
+static unsigned short correctColor(const unsigned short *lut, unsigned short value){
+  unsigned int i = value / 257u;
+  unsigned int fraction = value - i * 257u;
+  /* 65535 is entry 255 exactly; do not read past the table */
+  unsigned int next = i + (i < RCU_LUT_SIZE - 1);
+  return (unsigned short)((int)lut[i] + ((int)lut[next] - (int)lut[i]) * (int)fraction / 257);
+}
+
+/** Points per chunk of the position loops */
+#define CORRECT_CHUNK 256
+
+/** Smallest w of a point in front of the projection center */
+#define CORRECT_MIN_W 1e-6f
+
+/* Projective transform; the affine case is a separate loop without the
+ * divide. Both loops are free of branches so the compiler vectorizes them.
+ * Results go to a buffer on the stack first: with dst equal to src the
+ * compiler's alias check would fail and fall back to the scalar loop.
+ * The color loop stays scalar: its table lookups would need gathers of
+ * 16 bit entries. */
+static void correctPositions(const struct RCUCorrection *correction, const struct RCPoint *src, struct RCPoint *dst, unsigned int count){
+  const float m0 = correction->matrix[0], m1 = correction->matrix[1], m2 = correction->matrix[2];
+  const float m3 = correction->matrix[3], m4 = correction->matrix[4], m5 = correction->matrix[5];
+  const float m6 = correction->matrix[6], m7 = correction->matrix[7], m8 = correction->matrix[8];
+  const float scale = 1.0f / 32768.0f;
+  signed short tx[CORRECT_CHUNK], ty[CORRECT_CHUNK];
+  unsigned int base, i, n;
+  for(base = 0; base < count; base += n){
+    const struct RCPoint *s = src + base;
+    n = count - base < CORRECT_CHUNK ? count - base : CORRECT_CHUNK;
+    if(correction->affine){
+      for(i = 0; i < n; i++){
+        float x = s[i].x * scale;
+        float y = s[i].y * scale;
+        tx[i] = correctCoordinate(m0 * x + m1 * y + m2);
+        ty[i] = correctCoordinate(m3 * x + m4 * y + m5);
+      }
+    } else {
+      for(i = 0; i < n; i++){
+        float x = s[i].x * scale;
+        float y = s[i].y * scale;
+        float w = m6 * x + m7 * y + m8;
+        /* points behind the projection center are blanked by the color
+         * loop; keep the divide finite. max(w, CORRECT_MIN_W) is written
+         * with fabsf, as GCC does not if-convert a select that feeds a
+         * division. */
+        w = 1.0f / (0.5f * (w + CORRECT_MIN_W + fabsf(w - CORRECT_MIN_W)));
+        tx[i] = correctCoordinate((m0 * x + m1 * y + m2) * w);
+        ty[i] = correctCoordinate((m3 * x + m4 * y + m5) * w);
+      }
+    }
+    for(i = 0; i < n; i++){
+      dst[base + i].x = tx[i];
+      dst[base + i].y = ty[i];
+    }
+  }
+}
+
+/* Is the point behind the projection center, where it would flip? */
+static int correctBehind(const struct RCUCorrection *correction, const struct RCPoint *p){
+  const float scale = 1.0f / 32768.0f;
+  if(correction->affine){
+    return 0;
+  }
+  return correction->matrix[6] * (p->x * scale) + correction->matrix[7] * (p->y * scale) + correction->matrix[8] <= CORRECT_MIN_W;
+}
+
+void RCUCorrectionApply(const struct RCUCorrection *correction, const struct RCPoint *src, struct RCPoint *dst, unsigned int count){
+  unsigned int i;
+  /* colors first: the position loop may overwrite the source positions */
+  for(i = 0; i < count; i++){
+    unsigned short red = correctColor(correction->luts[RCUChannelRed], src[i].red);
+    unsigned short green = correctColor(correction->luts[RCUChannelGreen], src[i].green);
+    unsigned short blue = correctColor(correction->luts[RCUChannelBlue], src[i].blue);
+    unsigned short intensity = correctColor(correction->luts[RCUChannelIntensity], src[i].intensity);
+    unsigned short user1 = correctColor(correction->luts[RCUChannelUser1], src[i].user1);
+    unsigned short user2 = correctColor(correction->luts[RCUChannelUser2], src[i].user2);
+    if(correctBehind(correction, &src[i])){
+      red = green = blue = intensity = user1 = user2 = 0;
+    }
+    dst[i].red = red;
+    dst[i].green = green;
+    dst[i].blue = blue;
+    dst[i].intensity = intensity;
+    dst[i].user1 = user1;
+    dst[i].user2 = user2;
+  }
+  correctPositions(correction, src, dst, count);
+}
+
+int RCUCorrectionWriteFrame(const struct RCUCorrection *correction, int handle, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch){
+  if(correction == NULL || points == NULL || scratch == NULL){
+    return RCErrorParameterInvalid;
+  }
+  RCUCorrectionApply(correction, points, scratch, count);
+  return RCWriteFrame(handle, scratch, count, speed, repeat);
+}
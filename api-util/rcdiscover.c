@@ -0,0 +1,258 @@
+/* rcdiscover.c - background device discovery */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "rcutil.h"
+
+/** Maximum length of a device ID including terminating nul character */
+#define DISCOVERY_ID_LENGTH 256
+/** Granularity in ms at which the discovery thread checks for stop */
+#define DISCOVERY_STOP_POLL 10
+
+struct DiscoveryList {
+  unsigned int count;
+  char ids[RCU_DISCOVERY_MAX_DEVICES][DISCOVERY_ID_LENGTH];
+};
+
+struct RCUDiscovery {
+#if defined(_WIN32)
+  HANDLE thread;
+  SRWLOCK lock;
+  SRWLOCK scanLock;
+#else
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_mutex_t scanLock;
+#endif
+  unsigned int interval;
+  RCUDeviceCallback callback;
+  void *userData;
+  int stop;
+  /* list published to RCUDiscoveryCount() / RCUDiscoveryDeviceID() */
+  struct DiscoveryList list;
+  /* lists used by the discovery thread only */
+  struct DiscoveryList previous;
+  struct DiscoveryList current;
+};
+
+static void discoveryLock(struct RCUDiscovery *discovery){
+#if defined(_WIN32)
+  AcquireSRWLockExclusive(&discovery->lock);
+#else
+  pthread_mutex_lock(&discovery->lock);
+#endif
+}
+
+static void discoveryUnlock(struct RCUDiscovery *discovery){
+#if defined(_WIN32)
+  ReleaseSRWLockExclusive(&discovery->lock);
+#else
+  pthread_mutex_unlock(&discovery->lock);
+#endif
+}
+
+/* Held while the library's device list is enumerated, so that
+ * RCUDiscoveryOpen() does not call RCOpenDevice() during a scan. */
+static void discoveryScanLock(struct RCUDiscovery *discovery){
+#if defined(_WIN32)
+  AcquireSRWLockExclusive(&discovery->scanLock);
+#else
+  pthread_mutex_lock(&discovery->scanLock);
+#endif
+}
+
+static void discoveryScanUnlock(struct RCUDiscovery *discovery){
+#if defined(_WIN32)
+  ReleaseSRWLockExclusive(&discovery->scanLock);
+#else
+  pthread_mutex_unlock(&discovery->scanLock);
+#endif
+}
+
+static int discoveryStopped(struct RCUDiscovery *discovery){
+  int stop;
+  discoveryLock(discovery);
+  stop = discovery->stop;
+  discoveryUnlock(discovery);
+  return stop;
+}
+
+static int discoveryContains(const struct DiscoveryList *list, const char *id){
+  unsigned int i;
+  for(i = 0; i < list->count; i++){
+    if(strcmp(list->ids[i], id) == 0){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Enumerate the devices, publish the list and report the changes. */
+static void discoveryScan(struct RCUDiscovery *discovery){
+  struct DiscoveryList *previous = &discovery->previous;
+  struct DiscoveryList *current = &discovery->current;
+  unsigned int i;
+  int count;
+  discoveryScanLock(discovery);
+  count = RCEnumerateDevices();
+  if(count < 0){
+    /* keep the last list; the next scan will try again */
+    discoveryScanUnlock(discovery);
+    return;
+  }
+  if(count > RCU_DISCOVERY_MAX_DEVICES){
+    count = RCU_DISCOVERY_MAX_DEVICES;
+  }
+  current->count = 0;
+  for(i = 0; i < (unsigned int)count; i++){
+    if(RCDeviceID(i, current->ids[current->count], DISCOVERY_ID_LENGTH) > 0){
+      current->count++;
+    }
+  }
+  /* released before the callbacks, which may call RCUDiscoveryOpen() */
+  discoveryScanUnlock(discovery);
+
+  discoveryLock(discovery);
+  memcpy(&discovery->list, current, sizeof(*current));
+  discoveryUnlock(discovery);
+
+  if(discovery->callback != NULL){
+    for(i = 0; i < previous->count; i++){
+      if(!discoveryContains(current, previous->ids[i])){
+        discovery->callback(RCUDeviceLeft, previous->ids[i], discovery->userData);
+      }
+    }
+    for(i = 0; i < current->count; i++){
+      if(!discoveryContains(previous, current->ids[i])){
+        discovery->callback(RCUDeviceArrived, current->ids[i], discovery->userData);
+      }
+    }
+  }
+  memcpy(previous, current, sizeof(*current));
+}
+
+static void discoveryRun(struct RCUDiscovery *discovery){
+  while(!discoveryStopped(discovery)){
+    unsigned int waited;
+    discoveryScan(discovery);
+    for(waited = 0; waited < discovery->interval && !discoveryStopped(discovery); waited += DISCOVERY_STOP_POLL){
+      RCUSleep(DISCOVERY_STOP_POLL * 1000);
+    }
+  }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI discoveryThread(LPVOID arg){
+  discoveryRun((struct RCUDiscovery *)arg);
+  return 0;
+}
+#else
+static void *discoveryThread(void *arg){
+  discoveryRun((struct RCUDiscovery *)arg);
+  return NULL;
+}
+#endif
+
+struct RCUDiscovery *RCUDiscoveryStart(unsigned int interval, RCUDeviceCallback callback, void *userData){
+  struct RCUDiscovery *discovery = (struct RCUDiscovery *)calloc(1, sizeof(struct RCUDiscovery));
+  if(discovery == NULL){
+    return NULL;
+  }
+  discovery->interval = interval < RCU_DISCOVERY_MIN_INTERVAL ? RCU_DISCOVERY_MIN_INTERVAL : interval;
+  discovery->callback = callback;
+  discovery->userData = userData;
+#if defined(_WIN32)
+  InitializeSRWLock(&discovery->lock);
+  InitializeSRWLock(&discovery->scanLock);
+  discovery->thread = CreateThread(NULL, 0, discoveryThread, discovery, 0, NULL);
+  if(discovery->thread == NULL){
+    free(discovery);
+    return NULL;
+  }
+#else
+  pthread_mutex_init(&discovery->lock, NULL);
+  pthread_mutex_init(&discovery->scanLock, NULL);
+  if(pthread_create(&discovery->thread, NULL, discoveryThread, discovery) != 0){
+    pthread_mutex_destroy(&discovery->lock);
+    pthread_mutex_destroy(&discovery->scanLock);
+    free(discovery);
+    return NULL;
+  }
+#endif
+  return discovery;
+}
+
+void RCUDiscoveryStop(struct RCUDiscovery *discovery){
+  if(discovery == NULL){
+    return;
+  }
+  discoveryLock(discovery);
+  discovery->stop = 1;
+  discoveryUnlock(discovery);
+#if defined(_WIN32)
+  WaitForSingleObject(discovery->thread, INFINITE);
+  CloseHandle(discovery->thread);
+#else
+  pthread_join(discovery->thread, NULL);
+  pthread_mutex_destroy(&discovery->lock);
+  pthread_mutex_destroy(&discovery->scanLock);
+#endif
+  free(discovery);
+}
+
+int RCUDiscoveryCount(struct RCUDiscovery *discovery){
+  int count;
+  if(discovery == NULL){
+    return RCErrorParameterInvalid;
+  }
+  discoveryLock(discovery);
+  count = (int)discovery->list.count;
+  discoveryUnlock(discovery);
+  return count;
+}
+
+int RCUDiscoveryDeviceID(struct RCUDiscovery *discovery, unsigned int index, char *deviceId, unsigned int maxLength){
+  unsigned int length;
+  int ret;
+  if(discovery == NULL){
+    return RCErrorParameterInvalid;
+  }
+  discoveryLock(discovery);
+  if(index >= discovery->list.count){
+    ret = RCErrorParameterOutOfRange;
+  } else {
+    length = (unsigned int)strlen(discovery->list.ids[index]) + 1;
+    if(maxLength == 0){
+      ret = (int)length;
+    } else if(deviceId == NULL){
+      ret = RCErrorParameterInvalid;
+    } else {
+      if(length > maxLength){
+        length = maxLength;
+      }
+      memcpy(deviceId, discovery->list.ids[index], length - 1);
+      deviceId[length - 1] = '\0';
+      ret = (int)length;
+    }
+  }
+  discoveryUnlock(discovery);
+  return ret;
+}
+
+int RCUDiscoveryOpen(struct RCUDiscovery *discovery, const char *deviceId){
+  int handle;
+  if(discovery == NULL || deviceId == NULL){
+    return RCErrorParameterInvalid;
+  }
+  discoveryScanLock(discovery);
+  handle = RCOpenDevice(deviceId);
+  discoveryScanUnlock(discovery);
+  return handle;
+}
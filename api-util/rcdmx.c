@@ -0,0 +1,219 @@
+/* rcdmx.c - batched DMX output with change tracking */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rcutil.h"
+
+int RCUDmxInit(struct RCUDmx *dmx, unsigned int maxUniverses){
+  if(dmx == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(maxUniverses == 0){
+    return RCErrorParameterOutOfRange;
+  }
+  dmx->universes = (struct RCUDmxUniverse *)malloc(maxUniverses * sizeof(struct RCUDmxUniverse));
+  if(dmx->universes == NULL){
+    return RCErrorParameterOutOfRange;
+  }
+  dmx->count = 0;
+  dmx->maxUniverses = maxUniverses;
+  return RCOk;
+}
+
+void RCUDmxFree(struct RCUDmx *dmx){
+  free(dmx->universes);
+  dmx->universes = NULL;
+  dmx->count = 0;
+  dmx->maxUniverses = 0;
+}
+
+/* Find the state of a universe, adding it on first use. */
+static int dmxUniverse(struct RCUDmx *dmx, int handle, unsigned int universeIndex, struct RCUDmxUniverse **pUniverse){
+  struct RCUDmxUniverse *universe;
+  enum RCUniverseDirection direction;
+  unsigned int channels, i;
+  int ret;
+
+  for(i = 0; i < dmx->count; i++){
+    universe = &dmx->universes[i];
+    if(universe->handle == handle && universe->universeIndex == universeIndex){
+      *pUniverse = universe;
+      return RCOk;
+    }
+  }
+  if(dmx->count == dmx->maxUniverses){
+    return RCErrorParameterOutOfRange;
+  }
+  ret = RCUniverseQuery(handle, universeIndex, NULL, 0, &direction, &channels);
+  if(ret < RCOk){
+    return ret;
+  }
+  if(direction != RCOutput){
+    return RCErrorParameterInvalid;
+  }
+  universe = &dmx->universes[dmx->count++];
+  universe->handle = handle;
+  universe->universeIndex = universeIndex;
+  universe->channels = channels < RCU_DMX_CHANNELS ? channels : RCU_DMX_CHANNELS;
+  universe->dirtyStart = universe->dirtyEnd = 0;
+  universe->sent = 0;
+  memset(universe->data, 0, sizeof(universe->data));
+  *pUniverse = universe;
+  return RCOk;
+}
+
+int RCUDmxWrite(struct RCUDmx *dmx, const struct RCUDmxSpan *spans, unsigned int count){
+  unsigned int i;
+  if(dmx == NULL || (spans == NULL && count > 0)){
+    return RCErrorParameterInvalid;
+  }
+  for(i = 0; i < count; i++){
+    const struct RCUDmxSpan *span = &spans[i];
+    struct RCUDmxUniverse *universe;
+    unsigned int first, last;
+    int ret;
+
+    if(span->data == NULL){
+      return RCErrorParameterInvalid;
+    }
+    ret = dmxUniverse(dmx, span->handle, span->universeIndex, &universe);
+    if(ret < RCOk){
+      return ret;
+    }
+    if(span->startChannel > universe->channels || span->count > universe->channels - span->startChannel){
+      return RCErrorParameterOutOfRange;
+    }
+    if(span->count == 0){
+      continue;
+    }
+
+    /* Narrow the span to the channels that actually change. */
+    first = 0;
+    last = span->count;
+    if(universe->sent){
+      const unsigned char *old = universe->data + span->startChannel;
+      while(first < last && old[first] == span->data[first]){
+        first++;
+      }
+      while(last > first && old[last - 1] == span->data[last - 1]){
+        last--;
+      }
+      if(first == last){
+        continue;
+      }
+    }
+    memcpy(universe->data + span->startChannel + first, span->data + first, last - first);
+    first += span->startChannel;
+    last += span->startChannel;
+    if(universe->dirtyStart == universe->dirtyEnd){
+      universe->dirtyStart = first;
+      universe->dirtyEnd = last;
+    } else {
+      if(first < universe->dirtyStart){
+        universe->dirtyStart = first;
+      }
+      if(last > universe->dirtyEnd){
+        universe->dirtyEnd = last;
+      }
+    }
+  }
+  return RCOk;
+}
+
+int RCUDmxFlush(struct RCUDmx *dmx){
+  unsigned int i;
+  int updated = 0;
+  if(dmx == NULL){
+    return RCErrorParameterInvalid;
+  }
+  for(i = 0; i < dmx->count; i++){
+    struct RCUDmxUniverse *universe = &dmx->universes[i];
+    int ret;
+    if(universe->dirtyStart == universe->dirtyEnd){
+      continue;
+    }
+    if(!universe->sent){
+      /* channels never written are only 0 in data, not on the device */
+      universe->dirtyStart = 0;
+      universe->dirtyEnd = universe->channels;
+    }
+    ret = RCUniverseWrite(universe->handle, universe->universeIndex, universe->dirtyStart,
+      universe->data + universe->dirtyStart, universe->dirtyEnd - universe->dirtyStart);
+    if(ret >= RCOk){
+      ret = RCUniverseUpdate(universe->handle, universe->universeIndex);
+    }
+    if(ret < RCOk){
+      return ret;
+    }
+    universe->dirtyStart = universe->dirtyEnd = 0;
+    universe->sent = 1;
+    updated++;
+  }
+  return updated;
+}
+
+int RCUDmxInputInit(struct RCUDmxInput *input, int handle, unsigned int universeIndex, unsigned int pollInterval){
+  enum RCUniverseDirection direction;
+  unsigned int channels;
+  int ret;
+  if(input == NULL){
+    return RCErrorParameterInvalid;
+  }
+  ret = RCUniverseQuery(handle, universeIndex, NULL, 0, &direction, &channels);
+  if(ret < RCOk){
+    return ret;
+  }
+  if(direction != RCInput){
+    return RCErrorParameterInvalid;
+  }
+  input->handle = handle;
+  input->universeIndex = universeIndex;
+  input->channels = channels < RCU_DMX_CHANNELS ? channels : RCU_DMX_CHANNELS;
+  input->pollInterval = pollInterval;
+  memset(input->data, 0, sizeof(input->data));
+  ret = RCUniverseRead(handle, universeIndex, 0, input->data, input->channels);
+  return ret < RCOk ? ret : RCOk;
+}
+
+int RCUDmxInputWait(struct RCUDmxInput *input, int timeout, unsigned int *pFirstChannel, unsigned int *pEndChannel){
+  unsigned char data[RCU_DMX_CHANNELS];
+  long long deadline;
+  if(input == NULL){
+    return RCErrorParameterInvalid;
+  }
+  deadline = RCUClock() + (long long)timeout * 1000;
+  for(;;){
+    unsigned int first = 0, last = input->channels;
+    long long now;
+    int ret = RCUniverseRead(input->handle, input->universeIndex, 0, data, input->channels);
+    if(ret < RCOk){
+      return ret;
+    }
+    while(first < last && data[first] == input->data[first]){
+      first++;
+    }
+    if(first < last){
+      while(data[last - 1] == input->data[last - 1]){
+        last--;
+      }
+      memcpy(input->data + first, data + first, last - first);
+      if(pFirstChannel != NULL){
+        *pFirstChannel = first;
+      }
+      if(pEndChannel != NULL){
+        *pEndChannel = last;
+      }
+      return 1;
+    }
+    now = RCUClock();
+    if(timeout == 0 || (timeout > 0 && now >= deadline)){
+      return 0;
+    }
+    if(timeout > 0 && deadline - now < input->pollInterval){
+      RCUSleep((unsigned int)(deadline - now));
+    } else {
+      RCUSleep(input->pollInterval);
+    }
+  }
+}
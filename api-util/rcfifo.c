@@ -0,0 +1,161 @@
+/* rcfifo.c - point FIFO on top of RCWriteFrame() */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rcutil.h"
+
+int RCUFifoInit(struct RCUFifo *fifo, int handle, unsigned int chunkSize, unsigned int speed){
+  if(fifo == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(chunkSize == 0 || speed == 0){
+    return RCErrorParameterOutOfRange;
+  }
+  fifo->chunk = (struct RCPoint *)malloc(chunkSize * sizeof(struct RCPoint));
+  if(fifo->chunk == NULL){
+    return RCErrorParameterOutOfRange;
+  }
+  fifo->handle = handle;
+  fifo->speed = speed;
+  fifo->chunkSize = chunkSize;
+  fifo->fill = 0;
+  fifo->playEnd = 0;
+  fifo->pointsWritten = 0;
+  memset(&fifo->last, 0, sizeof(fifo->last));
+  return RCOk;
+}
+
+void RCUFifoFree(struct RCUFifo *fifo){
+  free(fifo->chunk);
+  fifo->chunk = NULL;
+  fifo->chunkSize = 0;
+  fifo->fill = 0;
+}
+
+static int fifoWrite(struct RCUFifo *fifo, const struct RCPoint *points, unsigned int count){
+  long long now;
+  int ret = RCWaitForReady(fifo->handle, -1);
+  if(ret < RCOk){
+    return ret;
+  }
+  ret = RCWriteFrame(fifo->handle, points, count, fifo->speed, 1);
+  if(ret < RCOk){
+    return ret;
+  }
+  /* If the device ran empty, playing restarts now. */
+  now = RCUClock();
+  if(fifo->playEnd < now){
+    fifo->playEnd = now;
+  }
+  fifo->playEnd += (long long)count * 1000000 / fifo->speed;
+  fifo->pointsWritten += count;
+  return RCOk;
+}
+
+int RCUFifoPush(struct RCUFifo *fifo, const struct RCPoint *points, unsigned int count){
+  if(fifo == NULL || (points == NULL && count > 0)){
+    return RCErrorParameterInvalid;
+  }
+  if(count > 0){
+    fifo->last = points[count - 1];
+  }
+  while(count > 0){
+    unsigned int n;
+    int ret;
+    /* Complete chunks are written straight from the caller's points. */
+    if(fifo->fill == 0 && count >= fifo->chunkSize){
+      ret = fifoWrite(fifo, points, fifo->chunkSize);
+      if(ret < RCOk){
+        return ret;
+      }
+      points += fifo->chunkSize;
+      count -= fifo->chunkSize;
+      continue;
+    }
+    n = fifo->chunkSize - fifo->fill;
+    if(n > count){
+      n = count;
+    }
+    memcpy(fifo->chunk + fifo->fill, points, n * sizeof(struct RCPoint));
+    fifo->fill += n;
+    points += n;
+    count -= n;
+    if(fifo->fill == fifo->chunkSize){
+      ret = fifoWrite(fifo, fifo->chunk, fifo->fill);
+      if(ret < RCOk){
+        return ret;
+      }
+      fifo->fill = 0;
+    }
+  }
+  return RCOk;
+}
+
+int RCUFifoFlush(struct RCUFifo *fifo){
+  int ret;
+  if(fifo == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(fifo->fill == 0){
+    return RCOk;
+  }
+  ret = fifoWrite(fifo, fifo->chunk, fifo->fill);
+  if(ret < RCOk){
+    return ret;
+  }
+  fifo->fill = 0;
+  return RCOk;
+}
+
+long long RCUFifoQueuedTime(const struct RCUFifo *fifo){
+  long long remaining = fifo->playEnd - RCUClock();
+  if(remaining < 0){
+    remaining = 0;
+  }
+  return remaining + (long long)fifo->fill * 1000000 / fifo->speed;
+}
+
+unsigned int RCUFifoQueued(const struct RCUFifo *fifo){
+  long long remaining = fifo->playEnd - RCUClock();
+  if(remaining < 0){
+    remaining = 0;
+  }
+  return (unsigned int)(remaining * fifo->speed / 1000000) + fifo->fill;
+}
+
+long long RCUFifoPlayTime(const struct RCUFifo *fifo){
+  long long now = RCUClock();
+  long long start = fifo->playEnd > now ? fifo->playEnd : now;
+  return start + (long long)fifo->fill * 1000000 / fifo->speed;
+}
+
+int RCUFifoPushAt(struct RCUFifo *fifo, const struct RCPoint *points, unsigned int count, long long presentationTime){
+  struct RCPoint blank[64];
+  unsigned int i;
+  if(fifo == NULL){
+    return RCErrorParameterInvalid;
+  }
+  for(i = 0; i < sizeof(blank) / sizeof(blank[0]); i++){
+    blank[i] = fifo->last;
+    blank[i].red = blank[i].green = blank[i].blue = 0;
+    blank[i].intensity = blank[i].user1 = blank[i].user2 = 0;
+  }
+  for(;;){
+    /* Recomputed after every chunk; the device may have run empty meanwhile. */
+    long long gap = presentationTime - RCUFifoPlayTime(fifo);
+    unsigned long long pad = gap > 0 ? (unsigned long long)gap * fifo->speed / 1000000 : 0;
+    int ret;
+    if(pad == 0){
+      break;
+    }
+    if(pad > sizeof(blank) / sizeof(blank[0])){
+      pad = sizeof(blank) / sizeof(blank[0]);
+    }
+    ret = RCUFifoPush(fifo, blank, (unsigned int)pad);
+    if(ret < RCOk){
+      return ret;
+    }
+  }
+  return RCUFifoPush(fifo, points, count);
+}
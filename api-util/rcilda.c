@@ -0,0 +1,376 @@
+/* rcilda.c - memory mapped ILDA file player */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "rcutil.h"
+
+/** Size of an ILDA section header */
+#define ILDA_HEADER_SIZE 32
+/** Number of frames read ahead by RCUIldaWriteFrame() */
+#define ILDA_READ_AHEAD 8
+/** Status bit of a blanked point */
+#define ILDA_BLANKED 0x40
+/** Palette offset denoting the ILDA default palette */
+#define ILDA_DEFAULT_PALETTE ((size_t)-1)
+
+struct IldaFrame {
+  /* offset of the section header */
+  size_t offset;
+  unsigned int format;
+  unsigned int records;
+  /* offset of the header of the palette in effect or ILDA_DEFAULT_PALETTE */
+  size_t palette;
+};
+
+struct RCUIlda {
+  const unsigned char *data;
+  size_t size;
+#if defined(_WIN32)
+  HANDLE file;
+  HANDLE mapping;
+#endif
+  /* frames indexed so far */
+  struct IldaFrame *frames;
+  unsigned int frameCount;
+  unsigned int frameCapacity;
+  /* indexing position; complete once the end of the file has been reached */
+  size_t scanOffset;
+  size_t scanPalette;
+  int complete;
+  /* palette loaded into colors */
+  size_t loadedPalette;
+  unsigned int colorCount;
+  unsigned char colors[256][3];
+  /* decode buffer of RCUIldaWriteFrame() */
+  struct RCPoint *points;
+  unsigned int maxPoints;
+};
+
+/* ILDA default palette */
+static const unsigned char ildaDefaultPalette[64][3] = {
+  {255,   0,   0}, {255,  16,   0}, {255,  32,   0}, {255,  48,   0},
+  {255,  64,   0}, {255,  80,   0}, {255,  96,   0}, {255, 112,   0},
+  {255, 128,   0}, {255, 144,   0}, {255, 160,   0}, {255, 176,   0},
+  {255, 192,   0}, {255, 208,   0}, {255, 224,   0}, {255, 240,   0},
+  {255, 255,   0}, {224, 255,   0}, {192, 255,   0}, {160, 255,   0},
+  {128, 255,   0}, { 96, 255,   0}, { 64, 255,   0}, { 32, 255,   0},
+  {  0, 255,   0}, {  0, 255,  36}, {  0, 255,  73}, {  0, 255, 109},
+  {  0, 255, 146}, {  0, 255, 182}, {  0, 255, 219}, {  0, 255, 255},
+  {  0, 227, 255}, {  0, 198, 255}, {  0, 170, 255}, {  0, 142, 255},
+  {  0, 113, 255}, {  0,  85, 255}, {  0,  56, 255}, {  0,  28, 255},
+  {  0,   0, 255}, { 32,   0, 255}, { 64,   0, 255}, { 96,   0, 255},
+  {128,   0, 255}, {160,   0, 255}, {192,   0, 255}, {224,   0, 255},
+  {255,   0, 255}, {255,  32, 255}, {255,  64, 255}, {255,  96, 255},
+  {255, 128, 255}, {255, 160, 255}, {255, 192, 255}, {255, 224, 255},
+  {255, 255, 255}, {255, 224, 224}, {255, 192, 192}, {255, 160, 160},
+  {255, 128, 128}, {255,  96,  96}, {255,  64,  64}, {255,  32,  32}
+};
+
+static unsigned int ildaU16(const unsigned char *p){
+  return (unsigned int)(p[0] << 8 | p[1]);
+}
+
+static signed short ildaS16(const unsigned char *p){
+  return (signed short)(unsigned short)(p[0] << 8 | p[1]);
+}
+
+/* Size of a record of the format, 0 for unknown formats. */
+static unsigned int ildaRecordSize(unsigned int format){
+  switch(format){
+  case 0: return 8;
+  case 1: return 6;
+  case 2: return 3;
+  case 3: return 4;
+  case 4: return 10;
+  case 5: return 8;
+  }
+  return 0;
+}
+
+/* Index section headers until frame index is known or the file ends. */
+static int ildaIndex(struct RCUIlda *ilda, unsigned int index){
+  while(!ilda->complete && ilda->frameCount <= index){
+    const unsigned char *header = ilda->data + ilda->scanOffset;
+    unsigned int format, records, recordSize;
+    size_t sectionSize;
+
+    if(ilda->size - ilda->scanOffset < ILDA_HEADER_SIZE || memcmp(header, "ILDA", 4) != 0){
+      ilda->complete = 1;
+      break;
+    }
+    format = header[7];
+    records = ildaU16(header + 24);
+    recordSize = ildaRecordSize(format);
+    sectionSize = ILDA_HEADER_SIZE + (size_t)records * recordSize;
+    /* zero records mark the end of the file; truncated sections end it too */
+    if(records == 0 || recordSize == 0 || ilda->size - ilda->scanOffset < sectionSize){
+      ilda->complete = 1;
+      break;
+    }
+    if(format == 2){
+      ilda->scanPalette = ilda->scanOffset;
+    } else if(format != 3){
+      if(ilda->frameCount == ilda->frameCapacity){
+        unsigned int capacity = ilda->frameCapacity ? ilda->frameCapacity * 2 : 256;
+        struct IldaFrame *frames = (struct IldaFrame *)realloc(ilda->frames, capacity * sizeof(struct IldaFrame));
+        if(frames == NULL){
+          return RCErrorParameterOutOfRange;
+        }
+        ilda->frames = frames;
+        ilda->frameCapacity = capacity;
+      }
+      ilda->frames[ilda->frameCount].offset = ilda->scanOffset;
+      ilda->frames[ilda->frameCount].format = format;
+      ilda->frames[ilda->frameCount].records = records;
+      ilda->frames[ilda->frameCount].palette = ilda->scanPalette;
+      ilda->frameCount++;
+    }
+    ilda->scanOffset += sectionSize;
+  }
+  return ilda->frameCount > index ? RCOk : RCErrorParameterOutOfRange;
+}
+
+static void ildaLoadPalette(struct RCUIlda *ilda, size_t palette){
+  if(ilda->loadedPalette == palette && ilda->colorCount != 0){
+    return;
+  }
+  if(palette == ILDA_DEFAULT_PALETTE){
+    memcpy(ilda->colors, ildaDefaultPalette, sizeof(ildaDefaultPalette));
+    ilda->colorCount = 64;
+  } else {
+    const unsigned char *header = ilda->data + palette;
+    unsigned int count = ildaU16(header + 24);
+    if(count > 256){
+      count = 256;
+    }
+    memcpy(ilda->colors, header + ILDA_HEADER_SIZE, count * 3);
+    ilda->colorCount = count;
+  }
+  ilda->loadedPalette = palette;
+}
+
+static void ildaSetColor(struct RCPoint *point, unsigned int status, unsigned int r, unsigned int g, unsigned int b){
+  if(status & ILDA_BLANKED){
+    r = g = b = 0;
+  }
+  point->red = (unsigned short)(r * 257);
+  point->green = (unsigned short)(g * 257);
+  point->blue = (unsigned short)(b * 257);
+  r = r > g ? r : g;
+  point->intensity = (unsigned short)((r > b ? r : b) * 257);
+  point->user1 = 0;
+  point->user2 = 0;
+}
+
+struct RCUIlda *RCUIldaOpen(const char *path){
+  struct RCUIlda *ilda;
+  if(path == NULL){
+    return NULL;
+  }
+  ilda = (struct RCUIlda *)calloc(1, sizeof(struct RCUIlda));
+  if(ilda == NULL){
+    return NULL;
+  }
+#if defined(_WIN32)
+  {
+    LARGE_INTEGER size;
+    ilda->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(ilda->file == INVALID_HANDLE_VALUE){
+      free(ilda);
+      return NULL;
+    }
+    if(!GetFileSizeEx(ilda->file, &size) || size.QuadPart < ILDA_HEADER_SIZE){
+      CloseHandle(ilda->file);
+      free(ilda);
+      return NULL;
+    }
+    ilda->size = (size_t)size.QuadPart;
+    ilda->mapping = CreateFileMappingA(ilda->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(ilda->mapping != NULL){
+      ilda->data = (const unsigned char *)MapViewOfFile(ilda->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if(ilda->data == NULL){
+      if(ilda->mapping != NULL){
+        CloseHandle(ilda->mapping);
+      }
+      CloseHandle(ilda->file);
+      free(ilda);
+      return NULL;
+    }
+  }
+#else
+  {
+    struct stat st;
+    void *data;
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+      free(ilda);
+      return NULL;
+    }
+    if(fstat(fd, &st) != 0 || st.st_size < ILDA_HEADER_SIZE){
+      close(fd);
+      free(ilda);
+      return NULL;
+    }
+    ilda->size = (size_t)st.st_size;
+    data = mmap(NULL, ilda->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    /* the mapping stays valid after closing the file */
+    close(fd);
+    if(data == MAP_FAILED){
+      free(ilda);
+      return NULL;
+    }
+    ilda->data = (const unsigned char *)data;
+  }
+#endif
+  if(memcmp(ilda->data, "ILDA", 4) != 0){
+    RCUIldaClose(ilda);
+    return NULL;
+  }
+  ilda->scanPalette = ILDA_DEFAULT_PALETTE;
+  return ilda;
+}
+
+void RCUIldaClose(struct RCUIlda *ilda){
+  if(ilda == NULL){
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(ilda->data);
+  CloseHandle(ilda->mapping);
+  CloseHandle(ilda->file);
+#else
+  munmap((void *)ilda->data, ilda->size);
+#endif
+  free(ilda->frames);
+  free(ilda->points);
+  free(ilda);
+}
+
+int RCUIldaFrameCount(struct RCUIlda *ilda){
+  int ret;
+  if(ilda == NULL){
+    return RCErrorParameterInvalid;
+  }
+  ret = ildaIndex(ilda, (unsigned int)-1);
+  if(ret < RCOk && !ilda->complete){
+    return ret;
+  }
+  return (int)ilda->frameCount;
+}
+
+int RCUIldaDecodeFrame(struct RCUIlda *ilda, unsigned int index, struct RCPoint *points, unsigned int maxPoints){
+  const struct IldaFrame *frame;
+  const unsigned char *record;
+  unsigned int i;
+  int ret;
+
+  if(ilda == NULL){
+    return RCErrorParameterInvalid;
+  }
+  ret = ildaIndex(ilda, index);
+  if(ret < RCOk){
+    return ret;
+  }
+  frame = &ilda->frames[index];
+  if(maxPoints == 0){
+    return (int)frame->records;
+  }
+  if(points == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(frame->records > maxPoints){
+    return RCErrorParameterOutOfRange;
+  }
+
+  record = ilda->data + frame->offset + ILDA_HEADER_SIZE;
+  switch(frame->format){
+  case 0:
+  case 1:
+    ildaLoadPalette(ilda, frame->palette);
+    for(i = 0; i < frame->records; i++){
+      /* 3D records carry z before the status byte; z is ignored */
+      const unsigned char *tail = record + (frame->format == 0 ? 6 : 4);
+      unsigned int color = tail[1];
+      const unsigned char *rgb = color < ilda->colorCount ? ilda->colors[color] : ildaDefaultPalette[56];
+      points[i].x = ildaS16(record);
+      points[i].y = ildaS16(record + 2);
+      ildaSetColor(&points[i], tail[0], rgb[0], rgb[1], rgb[2]);
+      record += frame->format == 0 ? 8 : 6;
+    }
+    break;
+  case 4:
+  case 5:
+    for(i = 0; i < frame->records; i++){
+      /* true color records store blue, green, red */
+      const unsigned char *tail = record + (frame->format == 4 ? 6 : 4);
+      points[i].x = ildaS16(record);
+      points[i].y = ildaS16(record + 2);
+      ildaSetColor(&points[i], tail[0], tail[3], tail[2], tail[1]);
+      record += frame->format == 4 ? 10 : 8;
+    }
+    break;
+  default:
+    return RCErrorParameterInvalid;
+  }
+  return (int)frame->records;
+}
+
+/* Ask the operating system to read the frames after index. */
+static void ildaReadAhead(struct RCUIlda *ilda, unsigned int index){
+#if defined(_WIN32)
+  (void)ilda;
+  (void)index;
+#else
+  size_t start, end;
+  size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  /* indexing may stop early at the end of the file */
+  ildaIndex(ilda, index + ILDA_READ_AHEAD);
+  if(index + 1 >= ilda->frameCount){
+    return;
+  }
+  start = ilda->frames[index + 1].offset;
+  end = index + ILDA_READ_AHEAD < ilda->frameCount ? ilda->frames[index + ILDA_READ_AHEAD].offset : ilda->scanOffset;
+  start -= start % pageSize;
+  posix_madvise((void *)(ilda->data + start), end - start, POSIX_MADV_WILLNEED);
+#endif
+}
+
+int RCUIldaWriteFrame(struct RCUIlda *ilda, int handle, unsigned int index, unsigned int speed, unsigned int repeat){
+  int count;
+  if(ilda == NULL){
+    return RCErrorParameterInvalid;
+  }
+  count = RCUIldaDecodeFrame(ilda, index, NULL, 0);
+  if(count < RCOk){
+    return count;
+  }
+  if((unsigned int)count > ilda->maxPoints){
+    struct RCPoint *points = (struct RCPoint *)realloc(ilda->points, (size_t)count * sizeof(struct RCPoint));
+    if(points == NULL){
+      return RCErrorParameterOutOfRange;
+    }
+    ilda->points = points;
+    ilda->maxPoints = (unsigned int)count;
+  }
+  count = RCUIldaDecodeFrame(ilda, index, ilda->points, ilda->maxPoints);
+  if(count < RCOk){
+    return count;
+  }
+  ildaReadAhead(ilda, index);
+  return RCWriteFrame(handle, ilda->points, (unsigned int)count, speed, repeat);
+}
@@ -0,0 +1,79 @@
+/* rclatest.c - latest frame wins submission */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rcutil.h"
+
+int RCULatestInit(struct RCULatest *latest, int handle, unsigned int maxPoints){
+  if(latest == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(maxPoints == 0){
+    return RCErrorParameterOutOfRange;
+  }
+  latest->points = (struct RCPoint *)malloc(maxPoints * sizeof(struct RCPoint));
+  if(latest->points == NULL){
+    return RCErrorParameterOutOfRange;
+  }
+  latest->handle = handle;
+  latest->maxPoints = maxPoints;
+  latest->count = 0;
+  latest->speed = 0;
+  latest->repeat = 0;
+  latest->buffers = 0;
+  latest->dropped = 0;
+  return RCOk;
+}
+
+void RCULatestFree(struct RCULatest *latest){
+  free(latest->points);
+  latest->points = NULL;
+  latest->maxPoints = 0;
+  latest->count = 0;
+}
+
+int RCULatestPump(struct RCULatest *latest){
+  int ret;
+  if(latest == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(latest->count == 0){
+    return 0;
+  }
+  ret = RCWaitForReady(latest->handle, 0);
+  if(ret < RCOk){
+    return ret;
+  }
+  /* The device buffer count is not reported; the highest number of free
+   * buffers seen is. Write only while at most the playing frame is queued. */
+  if(ret > latest->buffers){
+    latest->buffers = ret;
+  }
+  if(ret == 0 || ret < latest->buffers - 1){
+    return 0;
+  }
+  ret = RCWriteFrame(latest->handle, latest->points, latest->count, latest->speed, latest->repeat);
+  if(ret < RCOk){
+    return ret;
+  }
+  latest->count = 0;
+  return 1;
+}
+
+int RCULatestSubmit(struct RCULatest *latest, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat){
+  if(latest == NULL || points == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(count == 0 || count > latest->maxPoints){
+    return RCErrorParameterOutOfRange;
+  }
+  if(latest->count != 0){
+    latest->dropped++;
+  }
+  memcpy(latest->points, points, count * sizeof(struct RCPoint));
+  latest->count = count;
+  latest->speed = speed;
+  latest->repeat = repeat;
+  return RCULatestPump(latest);
+}
@@ -0,0 +1,64 @@
+/* rcmulti.c - start and write several devices together */
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "rcutil.h"
+
+/** Number of devices RCUWriteFrames() handles without allocating */
+#define MULTI_STACK_DEVICES 32
+
+int RCUStartOutputSynchronized(const int *handles, unsigned int count){
+  unsigned int i;
+  if(handles == NULL){
+    return RCErrorParameterInvalid;
+  }
+  for(i = 0; i < count; i++){
+    int ret = RCStartOutput(handles[i]);
+    if(ret < RCOk){
+      while(i-- > 0){
+        RCStopOutput(handles[i]);
+      }
+      return ret;
+    }
+  }
+  return RCOk;
+}
+
+int RCUWriteFrames(const int *handles, const struct RCPoint *const *points, const unsigned int *counts, unsigned int count, unsigned int speed, unsigned int repeat){
+  unsigned char stackFailed[MULTI_STACK_DEVICES];
+  unsigned char *failed = stackFailed;
+  unsigned int i;
+  int result = RCOk;
+  if(handles == NULL || points == NULL || counts == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(count > MULTI_STACK_DEVICES){
+    failed = (unsigned char *)malloc(count);
+    if(failed == NULL){
+      return RCErrorParameterOutOfRange;
+    }
+  }
+  /* a device whose wait fails is skipped, the others are still written */
+  for(i = 0; i < count; i++){
+    int ret = RCWaitForReady(handles[i], -1);
+    failed[i] = ret < RCOk;
+    if(ret < RCOk && result == RCOk){
+      result = ret;
+    }
+  }
+  for(i = 0; i < count; i++){
+    int ret;
+    if(failed[i]){
+      continue;
+    }
+    ret = RCWriteFrame(handles[i], points[i], counts[i], speed, repeat);
+    if(ret < RCOk && result == RCOk){
+      result = ret;
+    }
+  }
+  if(failed != stackFailed){
+    free(failed);
+  }
+  return result;
+}
@@ -0,0 +1,338 @@
+/* rcoptimize.c - path optimization */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rcutil.h"
+
+/** Grid cells per axis of the endpoint index */
+#define OPTIMIZE_GRID 16
+/** Grid cell size in coordinate units */
+#define OPTIMIZE_CELL (65536 / OPTIMIZE_GRID)
+
+/* Working memory, laid out in RCUOptimizer.work */
+struct OptimizeWork {
+  /* first and last source index of each segment in drawing direction */
+  unsigned int *segments;
+  unsigned int *order;
+  unsigned int *used;
+  /* endpoints (segment * 2 + end) sorted by grid cell */
+  unsigned int *cellStart;
+  unsigned int *cellEntries;
+  unsigned int count;
+};
+
+/* Output with bounds check */
+struct OptimizeOutput {
+  struct RCPoint *dst;
+  unsigned int count;
+  unsigned int maxCount;
+  int overflow;
+};
+
+static float optimizeDistance(const struct RCPoint *a, const struct RCPoint *b){
+  float dx = (float)a->x - (float)b->x;
+  float dy = (float)a->y - (float)b->y;
+  return sqrtf(dx * dx + dy * dy);
+}
+
+static unsigned int optimizeCell(signed short v){
+  return (unsigned int)((int)v + 32768) / OPTIMIZE_CELL;
+}
+
+static void optimizeWork(struct RCUOptimizer *optimizer, struct OptimizeWork *work){
+  unsigned int m = optimizer->maxPoints;
+  work->segments = optimizer->work;
+  work->order = work->segments + 2 * m;
+  work->used = work->order + m;
+  work->cellEntries = work->used + m;
+  work->cellStart = work->cellEntries + 2 * m;
+  work->count = 0;
+}
+
+static void optimizeEmit(struct OptimizeOutput *out, const struct RCPoint *p, unsigned int repeat, int blank){
+  unsigned int i;
+  for(i = 0; i < repeat; i++){
+    if(out->count >= out->maxCount){
+      out->overflow = 1;
+      return;
+    }
+    out->dst[out->count] = *p;
+    if(blank){
+      out->dst[out->count].red = out->dst[out->count].green = out->dst[out->count].blue = 0;
+      out->dst[out->count].intensity = out->dst[out->count].user1 = out->dst[out->count].user2 = 0;
+    }
+    out->count++;
+  }
+}
+
+/* Split the lit parts of the frame into segments. */
+static void optimizeSplit(struct OptimizeWork *work, const struct RCPoint *src, unsigned int count){
+  unsigned int i = 0;
+  while(i < count){
+    unsigned int first;
+    while(i < count && !RCUPointLit(&src[i])){
+      i++;
+    }
+    if(i == count){
+      break;
+    }
+    first = i;
+    while(i < count && RCUPointLit(&src[i])){
+      i++;
+    }
+    work->segments[2 * work->count] = first;
+    work->segments[2 * work->count + 1] = i - 1;
+    work->used[work->count] = 0;
+    work->count++;
+  }
+}
+
+/* Build the grid index of all segment endpoints (counting sort by cell). */
+static void optimizeIndex(struct OptimizeWork *work, const struct RCPoint *src){
+  unsigned int e, c, sum = 0;
+  memset(work->cellStart, 0, (OPTIMIZE_GRID * OPTIMIZE_GRID + 1) * sizeof(unsigned int));
+  for(e = 0; e < 2 * work->count; e++){
+    const struct RCPoint *p = &src[work->segments[e]];
+    work->cellStart[optimizeCell(p->y) * OPTIMIZE_GRID + optimizeCell(p->x)]++;
+  }
+  for(c = 0; c < OPTIMIZE_GRID * OPTIMIZE_GRID; c++){
+    sum += work->cellStart[c];
+    work->cellStart[c] = sum;
+  }
+  work->cellStart[OPTIMIZE_GRID * OPTIMIZE_GRID] = sum;
+  /* cellStart holds the end of each cell; filling decrements it to the start */
+  for(e = 0; e < 2 * work->count; e++){
+    const struct RCPoint *p = &src[work->segments[e]];
+    c = optimizeCell(p->y) * OPTIMIZE_GRID + optimizeCell(p->x);
+    work->cellEntries[--work->cellStart[c]] = e;
+  }
+}
+
+/* Find the closest endpoint of an unused segment, searching rings of cells
+ * around the position until no closer endpoint can exist. */
+static unsigned int optimizeNearest(const struct OptimizeWork *work, const struct RCPoint *src, const struct RCPoint *from){
+  int cx = (int)optimizeCell(from->x), cy = (int)optimizeCell(from->y);
+  unsigned int best = 0;
+  float bestDistance = -1.0f;
+  int r;
+  for(r = 0; r < OPTIMIZE_GRID; r++){
+    int x, y;
+    for(y = cy - r; y <= cy + r; y++){
+      if(y < 0 || y >= OPTIMIZE_GRID){
+        continue;
+      }
+      for(x = cx - r; x <= cx + r; x += (y == cy - r || y == cy + r) ? 1 : 2 * r){
+        unsigned int c, k;
+        if(x < 0 || x >= OPTIMIZE_GRID){
+          continue;
+        }
+        c = (unsigned int)(y * OPTIMIZE_GRID + x);
+        for(k = work->cellStart[c]; k < work->cellStart[c + 1]; k++){
+          unsigned int e = work->cellEntries[k];
+          float d;
+          if(work->used[e / 2]){
+            continue;
+          }
+          d = optimizeDistance(from, &src[work->segments[e]]);
+          if(bestDistance < 0.0f || d < bestDistance){
+            best = e;
+            bestDistance = d;
+          }
+        }
+        if(r == 0){
+          break;
+        }
+      }
+    }
+    if(bestDistance >= 0.0f && bestDistance <= (float)r * OPTIMIZE_CELL){
+      break;
+    }
+  }
+  return best;
+}
+
+/* Nearest neighbour tour; segments entered at their end are reversed. */
+static void optimizeTour(struct OptimizeWork *work, const struct RCPoint *src, const struct RCPoint *start){
+  const struct RCPoint *position = start;
+  unsigned int k;
+  for(k = 0; k < work->count; k++){
+    unsigned int e = optimizeNearest(work, src, position);
+    unsigned int s = e / 2;
+    if(e & 1){
+      unsigned int t = work->segments[2 * s];
+      work->segments[2 * s] = work->segments[2 * s + 1];
+      work->segments[2 * s + 1] = t;
+    }
+    work->used[s] = 1;
+    work->order[k] = s;
+    position = &src[work->segments[2 * s + 1]];
+  }
+}
+
+/* 2-opt on the closed tour; the first segment stays in place. Reversing
+ * the tour between i and j also reverses the drawing direction of the
+ * segments in between. */
+static void optimizeTwoOpt(struct OptimizeWork *work, const struct RCPoint *src, unsigned int passes){
+  unsigned int *seg = work->segments, *order = work->order;
+  unsigned int n = work->count, pass, i, j;
+  for(pass = 0; pass < passes; pass++){
+    int improved = 0;
+    for(i = 1; i + 1 < n; i++){
+      for(j = i + 1; j < n; j++){
+        const struct RCPoint *prevEnd = &src[seg[2 * order[i - 1] + 1]];
+        const struct RCPoint *first = &src[seg[2 * order[i]]];
+        const struct RCPoint *last = &src[seg[2 * order[j] + 1]];
+        const struct RCPoint *next = &src[seg[2 * order[j + 1 < n ? j + 1 : 0]]];
+        float before = optimizeDistance(prevEnd, first) + optimizeDistance(last, next);
+        float after = optimizeDistance(prevEnd, last) + optimizeDistance(first, next);
+        if(after < before - 1.0f){
+          unsigned int a = i, b = j, k;
+          while(a < b){
+            unsigned int t = order[a];
+            order[a++] = order[b];
+            order[b--] = t;
+          }
+          for(k = i; k <= j; k++){
+            unsigned int t = seg[2 * order[k]];
+            seg[2 * order[k]] = seg[2 * order[k] + 1];
+            seg[2 * order[k] + 1] = t;
+          }
+          improved = 1;
+        }
+      }
+    }
+    if(!improved){
+      break;
+    }
+  }
+}
+
+/* Blanked move with eased start and end, up to but excluding the target. */
+static void optimizeMove(struct OptimizeOutput *out, const struct RCUScannerProfile *profile, const struct RCPoint *from, const struct RCPoint *to){
+  struct RCPoint p = *to;
+  float distance = optimizeDistance(from, to);
+  unsigned int n, i;
+  optimizeEmit(out, from, profile->blankBefore, 1);
+  if(distance > 0.0f && profile->blankStep > 0){
+    /* the eased move is about 1.5 times as fast as a linear one at its center */
+    n = (unsigned int)ceilf(1.5f * distance / (float)profile->blankStep);
+    for(i = 1; i < n; i++){
+      float t = (float)i / (float)n;
+      t = t * t * (3.0f - 2.0f * t);
+      p.x = (signed short)((float)from->x + ((float)to->x - (float)from->x) * t);
+      p.y = (signed short)((float)from->y + ((float)to->y - (float)from->y) * t);
+      optimizeEmit(out, &p, 1, 1);
+    }
+  }
+}
+
+static void optimizeSegment(struct OptimizeOutput *out, const struct RCUScannerProfile *profile, const struct RCPoint *src, unsigned int first, unsigned int last){
+  int step = first <= last ? 1 : -1;
+  unsigned int i = first;
+  optimizeEmit(out, &src[first], profile->blankAfter, 1);
+  optimizeEmit(out, &src[first], profile->endDwell, 0);
+  for(;;){
+    unsigned int dwell = 0;
+    if(i != first && i != last && profile->cornerDwell > 0){
+      const struct RCPoint *a = &src[i - step], *b = &src[i], *c = &src[i + step];
+      float ax = (float)b->x - (float)a->x, ay = (float)b->y - (float)a->y;
+      float bx = (float)c->x - (float)b->x, by = (float)c->y - (float)b->y;
+      float l = sqrtf((ax * ax + ay * ay) * (bx * bx + by * by));
+      if(l > 0.0f){
+        /* 0 for straight lines, cornerDwell at 90 degrees, twice at 180 */
+        dwell = (unsigned int)((float)profile->cornerDwell * (1.0f - (ax * bx + ay * by) / l) + 0.5f);
+      }
+    }
+    optimizeEmit(out, &src[i], 1 + dwell, 0);
+    if(i == last){
+      break;
+    }
+    i += step;
+  }
+  optimizeEmit(out, &src[last], profile->endDwell, 0);
+}
+
+void RCUScannerProfileInit(struct RCUScannerProfile *profile){
+  profile->blankStep = 2000;
+  profile->blankBefore = 2;
+  profile->blankAfter = 3;
+  profile->endDwell = 2;
+  profile->cornerDwell = 3;
+  profile->passes = 4;
+}
+
+int RCUOptimizerInit(struct RCUOptimizer *optimizer, const struct RCUScannerProfile *profile, unsigned int maxPoints){
+  if(optimizer == NULL || profile == NULL){
+    return RCErrorParameterInvalid;
+  }
+  optimizer->profile = *profile;
+  optimizer->maxPoints = maxPoints;
+  optimizer->x = 0;
+  optimizer->y = 0;
+  optimizer->work = (unsigned int *)malloc((6 * (size_t)maxPoints + OPTIMIZE_GRID * OPTIMIZE_GRID + 1) * sizeof(unsigned int));
+  if(optimizer->work == NULL){
+    return RCErrorParameterOutOfRange;
+  }
+  return RCOk;
+}
+
+void RCUOptimizerFree(struct RCUOptimizer *optimizer){
+  if(optimizer == NULL){
+    return;
+  }
+  free(optimizer->work);
+  optimizer->work = NULL;
+}
+
+int RCUOptimizeFrame(struct RCUOptimizer *optimizer, const struct RCPoint *src, unsigned int count, struct RCPoint *dst, unsigned int maxCount){
+  struct OptimizeWork work;
+  struct OptimizeOutput out;
+  struct RCPoint anchor;
+  const struct RCPoint *position;
+  unsigned int k;
+  if(optimizer == NULL || src == NULL || dst == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(count > optimizer->maxPoints){
+    return RCErrorParameterOutOfRange;
+  }
+  memset(&anchor, 0, sizeof(anchor));
+  anchor.x = optimizer->x;
+  anchor.y = optimizer->y;
+  out.dst = dst;
+  out.count = 0;
+  out.maxCount = maxCount;
+  out.overflow = 0;
+
+  optimizeWork(optimizer, &work);
+  optimizeSplit(&work, src, count);
+  if(work.count == 0){
+    optimizeEmit(&out, &anchor, 1, 1);
+    return out.overflow ? RCErrorParameterOutOfRange : (int)out.count;
+  }
+  optimizeIndex(&work, src);
+  optimizeTour(&work, src, &anchor);
+  optimizeTwoOpt(&work, src, optimizer->profile.passes);
+
+  position = &src[work.segments[2 * work.order[0]]];
+  for(k = 0; k < work.count; k++){
+    unsigned int s = work.order[k];
+    if(k > 0){
+      optimizeMove(&out, &optimizer->profile, position, &src[work.segments[2 * s]]);
+    }
+    optimizeSegment(&out, &optimizer->profile, src, work.segments[2 * s], work.segments[2 * s + 1]);
+    position = &src[work.segments[2 * s + 1]];
+  }
+  /* close the loop; the frame starts with the settle points at the target */
+  anchor = src[work.segments[2 * work.order[0]]];
+  optimizeMove(&out, &optimizer->profile, position, &anchor);
+
+  if(out.overflow){
+    return RCErrorParameterOutOfRange;
+  }
+  optimizer->x = anchor.x;
+  optimizer->y = anchor.y;
+  return (int)out.count;
+}
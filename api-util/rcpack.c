@@ -0,0 +1,115 @@
+/* rcpack.c - packed point formats */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "rcutil.h"
+
+static void packU16(unsigned char *dst, unsigned short value){
+  dst[0] = (unsigned char)(value & 0xFF);
+  dst[1] = (unsigned char)(value >> 8);
+}
+
+static unsigned short unpackU16(const unsigned char *src){
+  return (unsigned short)(src[0] | (src[1] << 8));
+}
+
+static unsigned short maxColor(unsigned short r, unsigned short g, unsigned short b){
+  unsigned short m = r > g ? r : g;
+  return m > b ? m : b;
+}
+
+int RCUPointSize(enum RCUPointFormat format){
+  switch(format){
+  case RCUFormatRCPoint:
+    return (int)sizeof(struct RCPoint);
+  case RCUFormatXY16RGB8:
+    return 7;
+  case RCUFormatXY16RGB16:
+    return 10;
+  }
+  return RCErrorParameterInvalid;
+}
+
+int RCUPackPoints(enum RCUPointFormat format, const struct RCPoint *src, void *dst, unsigned int count){
+  unsigned char *out = (unsigned char *)dst;
+  unsigned int i;
+  if(src == NULL || dst == NULL){
+    return RCErrorParameterInvalid;
+  }
+  switch(format){
+  case RCUFormatRCPoint:
+    memcpy(dst, src, count * sizeof(struct RCPoint));
+    return RCOk;
+  case RCUFormatXY16RGB8:
+    for(i = 0; i < count; i++, out += 7){
+      packU16(out, (unsigned short)src[i].x);
+      packU16(out + 2, (unsigned short)src[i].y);
+      out[4] = (unsigned char)(src[i].red >> 8);
+      out[5] = (unsigned char)(src[i].green >> 8);
+      out[6] = (unsigned char)(src[i].blue >> 8);
+    }
+    return RCOk;
+  case RCUFormatXY16RGB16:
+    for(i = 0; i < count; i++, out += 10){
+      packU16(out, (unsigned short)src[i].x);
+      packU16(out + 2, (unsigned short)src[i].y);
+      packU16(out + 4, src[i].red);
+      packU16(out + 6, src[i].green);
+      packU16(out + 8, src[i].blue);
+    }
+    return RCOk;
+  }
+  return RCErrorParameterInvalid;
+}
+
+int RCUUnpackPoints(enum RCUPointFormat format, const void *src, struct RCPoint *dst, unsigned int count){
+  const unsigned char *in = (const unsigned char *)src;
+  unsigned int i;
+  if(src == NULL || dst == NULL){
+    return RCErrorParameterInvalid;
+  }
+  switch(format){
+  case RCUFormatRCPoint:
+    memcpy(dst, src, count * sizeof(struct RCPoint));
+    return RCOk;
+  case RCUFormatXY16RGB8:
+    for(i = 0; i < count; i++, in += 7){
+      /* v * 257 maps 0..255 to 0..65535 */
+      dst[i].x = (signed short)unpackU16(in);
+      dst[i].y = (signed short)unpackU16(in + 2);
+      dst[i].red = (unsigned short)(in[4] * 257);
+      dst[i].green = (unsigned short)(in[5] * 257);
+      dst[i].blue = (unsigned short)(in[6] * 257);
+      dst[i].intensity = maxColor(dst[i].red, dst[i].green, dst[i].blue);
+      dst[i].user1 = 0;
+      dst[i].user2 = 0;
+    }
+    return RCOk;
+  case RCUFormatXY16RGB16:
+    for(i = 0; i < count; i++, in += 10){
+      dst[i].x = (signed short)unpackU16(in);
+      dst[i].y = (signed short)unpackU16(in + 2);
+      dst[i].red = unpackU16(in + 4);
+      dst[i].green = unpackU16(in + 6);
+      dst[i].blue = unpackU16(in + 8);
+      dst[i].intensity = maxColor(dst[i].red, dst[i].green, dst[i].blue);
+      dst[i].user1 = 0;
+      dst[i].user2 = 0;
+    }
+    return RCOk;
+  }
+  return RCErrorParameterInvalid;
+}
+
+int RCUWriteFramePacked(int handle, enum RCUPointFormat format, const void *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch){
+  int ret;
+  if(format == RCUFormatRCPoint){
+    return RCWriteFrame(handle, (const struct RCPoint *)points, count, speed, repeat);
+  }
+  ret = RCUUnpackPoints(format, points, scratch, count);
+  if(ret < RCOk){
+    return ret;
+  }
+  return RCWriteFrame(handle, scratch, count, speed, repeat);
+}
@@ -0,0 +1,7 @@
+/* rcpoint.c - common point tests */
+
+#include "rcutil.h"
+
+int RCUPointLit(const struct RCPoint *point){
+  return (point->red | point->green | point->blue | point->user1 | point->user2) != 0;
+}
@@ -0,0 +1,108 @@
+/* rcresample.c - resampling to a lower sampling rate */
+
+#include <stddef.h>
+
+#include "rcutil.h"
+
+/** Corners turning by more than this angle (cos 45 degrees) are kept */
+#define RESAMPLE_CORNER_COS 0.7071f
+
+/* Is point i a blanking transition or a sharp corner? */
+static int resampleKey(const struct RCPoint *src, unsigned int count, unsigned int i){
+  float ax, ay, bx, by, dot, la, lb;
+  if(i == 0 || i + 1 >= count){
+    return 0;
+  }
+  if(RCUPointLit(&src[i - 1]) != RCUPointLit(&src[i])){
+    return 1;
+  }
+  ax = (float)src[i].x - (float)src[i - 1].x;
+  ay = (float)src[i].y - (float)src[i - 1].y;
+  bx = (float)src[i + 1].x - (float)src[i].x;
+  by = (float)src[i + 1].y - (float)src[i].y;
+  la = ax * ax + ay * ay;
+  lb = bx * bx + by * by;
+  if(la == 0.0f || lb == 0.0f){
+    /* repeated points are dwell at a corner or on a blanking move */
+    return la != lb;
+  }
+  dot = ax * bx + ay * by;
+  return dot < 0.0f || dot * dot < RESAMPLE_CORNER_COS * RESAMPLE_CORNER_COS * la * lb;
+}
+
+int RCUResampleCount(unsigned int count, unsigned int speed, unsigned int targetSpeed){
+  unsigned long long n;
+  if(speed == 0 || targetSpeed == 0){
+    return RCErrorParameterOutOfRange;
+  }
+  n = ((unsigned long long)count * targetSpeed + speed - 1) / speed;
+  if(n > 0x7FFFFFFF){
+    return RCErrorParameterOutOfRange;
+  }
+  return (int)n;
+}
+
+int RCUResample(const struct RCPoint *src, unsigned int count, unsigned int speed, struct RCPoint *dst, unsigned int maxCount, unsigned int targetSpeed){
+  double step;
+  unsigned int j, n, scan = 0;
+  int ret;
+  if(src == NULL || dst == NULL){
+    return RCErrorParameterInvalid;
+  }
+  ret = RCUResampleCount(count, speed, targetSpeed);
+  if(ret < RCOk){
+    return ret;
+  }
+  if(targetSpeed > speed || (unsigned int)ret > maxCount){
+    return RCErrorParameterOutOfRange;
+  }
+  n = (unsigned int)ret;
+  step = (double)speed / targetSpeed;
+  for(j = 0; j < n; j++){
+    double t = j * step;
+    unsigned int end = (unsigned int)((j + 1) * step);
+    unsigned int i = (unsigned int)t;
+    const struct RCPoint *a, *b;
+    float f;
+    if(end > count){
+      end = count;
+    }
+    /* output point j stands for the source points [t, end); emit the first
+     * key point among them exactly */
+    if(scan < i){
+      scan = i;
+    }
+    while(scan < end && !resampleKey(src, count, scan)){
+      scan++;
+    }
+    if(scan < end){
+      dst[j] = src[scan++];
+      continue;
+    }
+    a = &src[i];
+    b = i + 1 < count ? &src[i + 1] : a;
+    dst[j] = *a;
+    if(RCUPointLit(a) == RCUPointLit(b)){
+      f = (float)(t - i);
+      dst[j].x = (signed short)((float)a->x + ((float)b->x - (float)a->x) * f);
+      dst[j].y = (signed short)((float)a->y + ((float)b->y - (float)a->y) * f);
+    }
+  }
+  return (int)n;
+}
+
+int RCUWriteFrameResampled(int handle, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch, unsigned int scratchCount){
+  int maxSpeed = RCMaxSpeed(handle);
+  int ret;
+  if(maxSpeed < RCOk){
+    return maxSpeed;
+  }
+  if(maxSpeed == 0 || speed <= (unsigned int)maxSpeed){
+    return RCWriteFrame(handle, points, count, speed, repeat);
+  }
+  ret = RCUResample(points, count, speed, scratch, scratchCount, (unsigned int)maxSpeed);
+  if(ret < RCOk){
+    return ret;
+  }
+  return RCWriteFrame(handle, scratch, (unsigned int)ret, (unsigned int)maxSpeed, repeat);
+}
@@ -0,0 +1,217 @@
+/* rcsafety.c - safety zone masking */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "rcutil.h"
+
+/** Highest accepted sampling rate; a point lasts at least 1 ns */
+#define SAFETY_MAX_SPEED 1000000000u
+
+static void safetyBlank(struct RCPoint *p){
+  p->red = p->green = p->blue = 0;
+  p->intensity = p->user1 = p->user2 = 0;
+}
+
+/* Crossing number test; points on the left or bottom edge count as inside. */
+static int safetyInside(const struct RCUSafetyZone *zone, signed short px, signed short py){
+  unsigned int i, j;
+  int inside = 0;
+  if(px < zone->minX || px > zone->maxX || py < zone->minY || py > zone->maxY){
+    return 0;
+  }
+  for(i = 0, j = zone->vertexCount - 1; i < zone->vertexCount; j = i++){
+    float xi = zone->x[i], yi = zone->y[i], xj = zone->x[j], yj = zone->y[j];
+    if((yi > py) != (yj > py) && px < xi + (xj - xi) * ((float)py - yi) / (yj - yi)){
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+/* Orientation of c relative to the line a-b */
+static long long safetyCross(long long ax, long long ay, long long bx, long long by, long long cx, long long cy){
+  return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+/* Do the segments p-q and a-b intersect or touch? Exact on integers. */
+static int safetySegments(long long px, long long py, long long qx, long long qy, long long ax, long long ay, long long bx, long long by){
+  long long d1 = safetyCross(ax, ay, bx, by, px, py);
+  long long d2 = safetyCross(ax, ay, bx, by, qx, qy);
+  long long d3 = safetyCross(px, py, qx, qy, ax, ay);
+  long long d4 = safetyCross(px, py, qx, qy, bx, by);
+  if(((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))){
+    return 1;
+  }
+  /* collinear touching: an endpoint lies within the other segment's box */
+  return (d1 == 0 && px >= (ax < bx ? ax : bx) && px <= (ax > bx ? ax : bx) && py >= (ay < by ? ay : by) && py <= (ay > by ? ay : by))
+    || (d2 == 0 && qx >= (ax < bx ? ax : bx) && qx <= (ax > bx ? ax : bx) && qy >= (ay < by ? ay : by) && qy <= (ay > by ? ay : by))
+    || (d3 == 0 && ax >= (px < qx ? px : qx) && ax <= (px > qx ? px : qx) && ay >= (py < qy ? py : qy) && ay <= (py > qy ? py : qy))
+    || (d4 == 0 && bx >= (px < qx ? px : qx) && bx <= (px > qx ? px : qx) && by >= (py < qy ? py : qy) && by <= (py > qy ? py : qy));
+}
+
+/* Does the line from p to q cross an edge of the zone? Lines with an end
+ * inside the zone are found by the point test. */
+static int safetyCrosses(const struct RCUSafetyZone *zone, const struct RCPoint *p, const struct RCPoint *q){
+  unsigned int i, j;
+  if((p->x < zone->minX && q->x < zone->minX) || (p->x > zone->maxX && q->x > zone->maxX)
+    || (p->y < zone->minY && q->y < zone->minY) || (p->y > zone->maxY && q->y > zone->maxY)){
+    return 0;
+  }
+  for(i = 0, j = zone->vertexCount - 1; i < zone->vertexCount; j = i++){
+    if(safetySegments(p->x, p->y, q->x, q->y, zone->x[j], zone->y[j], zone->x[i], zone->y[i])){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void safetyBlankCounted(struct RCUSafetyZone *zone, struct RCPoint *p){
+  if((p->red | p->green | p->blue | p->intensity | p->user1 | p->user2) != 0){
+    safetyBlank(p);
+    zone->blanked++;
+  }
+}
+
+/* Points may be blanked in place, so the lit state and position of the
+ * previous point are kept from before blanking. */
+static void safetyForbid(struct RCUSafetyZone *zone, struct RCPoint *points, unsigned int count){
+  struct RCPoint first = points[0], previous = points[count - 1];
+  int wrap, previousLit = RCUPointLit(&previous);
+  unsigned int i;
+  wrap = (previousLit || RCUPointLit(&first)) && safetyCrosses(zone, &previous, &first);
+  for(i = 0; i < count; i++){
+    struct RCPoint current = points[i];
+    int lit = RCUPointLit(&current);
+    if(safetyInside(zone, current.x, current.y)){
+      safetyBlankCounted(zone, &points[i]);
+    }
+    if(i > 0 && (lit || previousLit) && safetyCrosses(zone, &previous, &current)){
+      safetyBlankCounted(zone, &points[i - 1]);
+      safetyBlankCounted(zone, &points[i]);
+    }
+    previous = current;
+    previousLit = lit;
+  }
+  if(wrap){
+    safetyBlankCounted(zone, &points[count - 1]);
+    safetyBlankCounted(zone, &points[0]);
+  }
+}
+
+static void safetyLimit(struct RCUSafetyZone *zone, struct RCPoint *points, unsigned int count, long long pointTime){
+  unsigned int i;
+  for(i = 0; i < count; i++){
+    if(!RCUPointLit(&points[i]) || !safetyInside(zone, points[i].x, points[i].y)){
+      continue;
+    }
+    /* exposure never exceeds the budget, so this cannot overflow */
+    if(pointTime <= zone->budget - zone->exposure){
+      zone->exposure += pointTime;
+      continue;
+    }
+    safetyBlankCounted(zone, &points[i]);
+  }
+}
+
+int RCUSafetyInit(struct RCUSafety *safety, int handle, unsigned int window){
+  if(safety == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(window == 0){
+    return RCErrorParameterOutOfRange;
+  }
+  safety->handle = handle;
+  safety->window = window;
+  safety->windowStart = RCUClock();
+  safety->zoneCount = 0;
+  return RCOk;
+}
+
+int RCUSafetyAddZone(struct RCUSafety *safety, enum RCUZoneType type, const signed short *x, const signed short *y, unsigned int vertexCount, unsigned int budget){
+  struct RCUSafetyZone *zone;
+  unsigned int i;
+  if(safety == NULL || x == NULL || y == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(type != RCUZoneForbidden && type != RCUZoneLimited){
+    return RCErrorParameterInvalid;
+  }
+  if(vertexCount < 3 || vertexCount > RCU_SAFETY_MAX_VERTICES || safety->zoneCount >= RCU_SAFETY_MAX_ZONES){
+    return RCErrorParameterOutOfRange;
+  }
+  zone = &safety->zones[safety->zoneCount];
+  memset(zone, 0, sizeof(*zone));
+  zone->type = type;
+  zone->vertexCount = vertexCount;
+  zone->minX = zone->maxX = x[0];
+  zone->minY = zone->maxY = y[0];
+  for(i = 0; i < vertexCount; i++){
+    zone->x[i] = x[i];
+    zone->y[i] = y[i];
+    if(x[i] < zone->minX) zone->minX = x[i];
+    if(x[i] > zone->maxX) zone->maxX = x[i];
+    if(y[i] < zone->minY) zone->minY = y[i];
+    if(y[i] > zone->maxY) zone->maxY = y[i];
+  }
+  zone->budget = type == RCUZoneLimited ? (long long)budget * 1000 : 0;
+  return (int)safety->zoneCount++;
+}
+
+int RCUSafetyApply(struct RCUSafety *safety, const struct RCPoint *src, struct RCPoint *dst, unsigned int count, unsigned int speed, unsigned int repeat){
+  long long now, pointTime;
+  unsigned int i;
+  if(safety == NULL || src == NULL || dst == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(speed == 0 || speed > SAFETY_MAX_SPEED){
+    return RCErrorParameterOutOfRange;
+  }
+  if(dst != src){
+    memcpy(dst, src, count * sizeof(struct RCPoint));
+  }
+  if(count == 0){
+    return RCOk;
+  }
+
+  now = RCUClock();
+  if(now - safety->windowStart >= safety->window){
+    safety->windowStart = now;
+    for(i = 0; i < safety->zoneCount; i++){
+      safety->zones[i].exposure = 0;
+    }
+  }
+  if(repeat == 0){
+    /* Plays until replaced. Within a window a point is lit for at most its
+     * share of the window plus one more pass. */
+    pointTime = ((long long)safety->window * 1000 + count - 1) / count + (1000000000LL + speed - 1) / speed;
+  }else{
+    /* repeat < 2^32, so this stays below 2^63 */
+    pointTime = ((long long)repeat * 1000000000LL + speed - 1) / speed;
+  }
+
+  /* forbidden zones first, so blanked points do not use up budgets */
+  for(i = 0; i < safety->zoneCount; i++){
+    if(safety->zones[i].type == RCUZoneForbidden){
+      safetyForbid(&safety->zones[i], dst, count);
+    }
+  }
+  for(i = 0; i < safety->zoneCount; i++){
+    if(safety->zones[i].type == RCUZoneLimited){
+      safetyLimit(&safety->zones[i], dst, count, pointTime);
+    }
+  }
+  return RCOk;
+}
+
+int RCUSafetyWriteFrame(struct RCUSafety *safety, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch){
+  int ret;
+  if(scratch == NULL){
+    return RCErrorParameterInvalid;
+  }
+  ret = RCUSafetyApply(safety, points, scratch, count, speed, repeat);
+  if(ret < RCOk){
+    return ret;
+  }
+  return RCWriteFrame(safety->handle, scratch, count, speed, repeat);
+}
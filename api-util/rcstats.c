@@ -0,0 +1,96 @@
+/* rcstats.c - output statistics */
+
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "rcutil.h"
+
+/* Spin lock around updates and snapshots. Both only copy a few hundred
+ * bytes, so spinning is cheaper than a kernel lock and the statistics stay
+ * a plain structure without Init/Free. */
+static void statsLock(struct RCUOutputStats *stats){
+#if defined(_WIN32)
+  while(InterlockedCompareExchange(&stats->lock, 1, 0) != 0){
+    YieldProcessor();
+  }
+#else
+  while(__sync_lock_test_and_set(&stats->lock, 1) != 0){
+  }
+#endif
+}
+
+static void statsUnlock(struct RCUOutputStats *stats){
+#if defined(_WIN32)
+  InterlockedExchange(&stats->lock, 0);
+#else
+  __sync_lock_release(&stats->lock);
+#endif
+}
+
+static void statsRecord(unsigned long long *histogram, long long microseconds){
+  unsigned int bucket = 0;
+  while(microseconds >= 2 && bucket < RCU_STATS_BUCKETS - 1){
+    microseconds >>= 1;
+    bucket++;
+  }
+  histogram[bucket]++;
+}
+
+void RCUStatsReset(struct RCUOutputStats *stats){
+  memset(stats, 0, sizeof(*stats));
+}
+
+void RCUStatsSnapshot(struct RCUOutputStats *stats, struct RCUOutputStats *snapshot){
+  statsLock(stats);
+  memcpy(snapshot, stats, sizeof(*snapshot));
+  statsUnlock(stats);
+  snapshot->lock = 0;
+}
+
+int RCUStatsWaitForReady(struct RCUOutputStats *stats, int handle, int timeout){
+  long long start = RCUClock();
+  int ret = RCWaitForReady(handle, timeout);
+  long long elapsed = RCUClock() - start;
+  statsLock(stats);
+  statsRecord(stats->waitLatency, elapsed);
+  if(ret < RCOk){
+    stats->errors++;
+  } else if(ret > stats->buffers){
+    stats->buffers = ret;
+  }
+  statsUnlock(stats);
+  return ret;
+}
+
+int RCUStatsWriteFrame(struct RCUOutputStats *stats, int handle, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat){
+  long long start, elapsed;
+  int ret = RCWaitForReady(handle, 0);
+  if(ret >= RCOk){
+    statsLock(stats);
+    if(ret > stats->buffers){
+      stats->buffers = ret;
+    }
+    /* All buffers free after the first frame: the device ran empty. */
+    if(ret == stats->buffers && stats->frames > 0){
+      stats->underruns++;
+    }
+    stats->queueDepth = stats->buffers - ret;
+    statsUnlock(stats);
+  }
+  start = RCUClock();
+  ret = RCWriteFrame(handle, points, count, speed, repeat);
+  elapsed = RCUClock() - start;
+  statsLock(stats);
+  statsRecord(stats->writeLatency, elapsed);
+  if(ret < RCOk){
+    stats->errors++;
+  } else {
+    stats->frames++;
+    stats->points += count;
+  }
+  statsUnlock(stats);
+  return ret;
+}
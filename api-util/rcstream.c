@@ -0,0 +1,99 @@
+/* rcstream.c - callback driven output of several devices from one thread */
+
+#include <stdlib.h>
+
+#include "rcutil.h"
+
+/** Time to wait for a free buffer between polls in ms */
+#define STREAM_POLL_TIMEOUT 1
+
+int RCUStreamInit(struct RCUStream *stream, int handle, unsigned int maxPoints, unsigned int speed, RCUFrameCallback callback, void *userData){
+  if(stream == NULL || callback == NULL){
+    return RCErrorParameterInvalid;
+  }
+  if(maxPoints == 0 || speed == 0){
+    return RCErrorParameterOutOfRange;
+  }
+  stream->points = (struct RCPoint *)malloc(maxPoints * sizeof(struct RCPoint));
+  if(stream->points == NULL){
+    return RCErrorParameterOutOfRange;
+  }
+  stream->handle = handle;
+  stream->callback = callback;
+  stream->userData = userData;
+  stream->maxPoints = maxPoints;
+  stream->speed = speed;
+  stream->repeat = 0;
+  stream->status = RCOk;
+  return RCOk;
+}
+
+void RCUStreamFree(struct RCUStream *stream){
+  free(stream->points);
+  stream->points = NULL;
+  stream->maxPoints = 0;
+}
+
+/* Fill all free buffers of the device. Returns 1 if all buffers of the
+ * device are in use afterwards, 0 otherwise; *pWritten counts the frames. */
+static int streamService(struct RCUStream *stream, int *pWritten){
+  for(;;){
+    int count;
+    int ret = RCWaitForReady(stream->handle, 0);
+    if(ret <= 0){
+      if(ret < RCOk){
+        stream->status = ret;
+      }
+      return ret == 0;
+    }
+    count = stream->callback(stream->handle, stream->points, stream->maxPoints, &stream->speed, &stream->repeat, stream->userData);
+    if(count <= 0){
+      if(count < 0){
+        stream->status = 1;
+      }
+      return 0;
+    }
+    if((unsigned int)count > stream->maxPoints){
+      stream->status = RCErrorParameterOutOfRange;
+      return 0;
+    }
+    ret = RCWriteFrame(stream->handle, stream->points, (unsigned int)count, stream->speed, stream->repeat);
+    if(ret < RCOk){
+      stream->status = ret;
+      return 0;
+    }
+    (*pWritten)++;
+  }
+}
+
+int RCUStreamRun(struct RCUStream *streams, unsigned int count, int timeout){
+  long long deadline = RCUClock() + (long long)timeout * 1000;
+  for(;;){
+    unsigned int i;
+    int active = 0, written = 0, fullHandle = 0, full = 0;
+    for(i = 0; i < count; i++){
+      if(streams[i].status != RCOk){
+        continue;
+      }
+      if(streamService(&streams[i], &written) && !full){
+        full = 1;
+        fullHandle = streams[i].handle;
+      }
+      if(streams[i].status == RCOk){
+        active++;
+      }
+    }
+    if(active == 0 || timeout == 0 || (timeout > 0 && RCUClock() >= deadline)){
+      return active;
+    }
+    if(written == 0){
+      /* Nothing to do: wait for a buffer of a busy device so it is serviced
+       * without delay, the other devices are polled once per timeout. */
+      if(full){
+        RCWaitForReady(fullHandle, STREAM_POLL_TIMEOUT);
+      } else {
+        RCUSleep(STREAM_POLL_TIMEOUT * 1000);
+      }
+    }
+  }
+}
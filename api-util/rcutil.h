@@ -0,0 +1,1371 @@
+#ifndef RAYCOMPOSER_DEVICE_UTIL_H
+#define RAYCOMPOSER_DEVICE_UTIL_H
+
+/** \file rcutil.h
+  *  \brief RayComposer device API utilities
+  *
+  *  Helper functions built on top of the public RayComposer device API
+  *  declared in rcdev.h. The utilities are provided as source code; compile
+  *  the .c files in this directory together with your application.
+  *
+  *  The utilities only use the functions declared in rcdev.h and work with
+  *  every device library version since 1.06. They keep all state in the
+  *  structures passed to them, so functions working on different structures
+  *  may be called from different threads, as far as the device library
+  *  allows concurrent calls on the device handles involved.
+  */
+
+#include "rcdev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \defgroup clock Clock
+ *
+ * \brief Monotonic time and sleeping.
+ *
+ *  @{
+ */
+
+/** \brief Read the monotonic clock.
+  *
+  * \return The time in microseconds since an unspecified starting point.
+  */
+long long RCUClock(void);
+
+/** \brief Sleep.
+  *
+  * \param microseconds Time to sleep in microseconds. The actual resolution
+  * depends on the operating system.
+  */
+void RCUSleep(unsigned int microseconds);
+
+/** @} */
+
+/** \defgroup stream Streaming
+ *
+ * \brief Drive several devices from one thread using frame callbacks.
+ *
+ * Instead of one thread per device blocking in RCWaitForReady(), the
+ * streams of all devices are serviced by RCUStreamRun() in the calling
+ * thread. Whenever a device has a free buffer its callback is asked for
+ * the next frame, which is written right away.
+ *
+ * The device library has no buffer-free notification, so RCUStreamRun()
+ * waits in RCWaitForReady() on one device with a timeout of 1 ms between
+ * polls of all devices.
+ *
+ *  @{
+ */
+
+/** \brief Frame callback
+ *
+ * Called by RCUStreamRun() when the device has a free buffer.
+ *
+ * \param handle Device handle of the stream
+ * \param points Buffer for the frame to write
+ * \param maxPoints Capacity of points
+ * \param pSpeed Sampling rate for the frame; preset with the value of the
+ * previous frame
+ * \param pRepeat Repeat count for the frame, see RCWriteFrame(); preset with
+ * the value of the previous frame
+ * \param userData User data passed to RCUStreamInit()
+ * \return The number of points in the frame. If 0, nothing is written and the
+ * callback will be asked again on the next poll. If negative, the stream ends.
+ */
+typedef int (*RCUFrameCallback)(int handle, struct RCPoint *points, unsigned int maxPoints, unsigned int *pSpeed, unsigned int *pRepeat, void *userData);
+
+/**
+ * @brief Stream State
+ *
+ * State of one device stream. Initialise with RCUStreamInit(), release
+ * with RCUStreamFree().
+ */
+struct RCUStream {
+  /** Device handle; output must have been started with RCStartOutput() */
+  int handle;
+  /** Frame callback */
+  RCUFrameCallback callback;
+  /** User data passed to the callback */
+  void *userData;
+  /** Frame buffer passed to the callback */
+  struct RCPoint *points;
+  /** Capacity of the frame buffer */
+  unsigned int maxPoints;
+  /** Sampling rate of the last frame */
+  unsigned int speed;
+  /** Repeat count of the last frame */
+  unsigned int repeat;
+  /** RCOk while the stream is active, 1 after the callback ended it or a
+   * negative RCReturnCode error code if writing failed */
+  int status;
+};
+
+/** \brief Initialise a stream.
+  *
+  * \param stream Stream to initialise
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param maxPoints Capacity of the frame buffer passed to the callback
+  * \param speed Initial sampling rate in Hz
+  * \param callback Frame callback
+  * \param userData User data passed to the callback
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUStreamInit(struct RCUStream *stream, int handle, unsigned int maxPoints, unsigned int speed, RCUFrameCallback callback, void *userData);
+
+/** \brief Release the frame buffer of a stream.
+  *
+  * \param stream Stream initialised with RCUStreamInit()
+  */
+void RCUStreamFree(struct RCUStream *stream);
+
+/** \brief Service streams.
+  *
+  * Calls the frame callbacks of all active streams whenever their device has
+  * a free buffer and writes the frames, until all streams have ended or the
+  * timeout elapsed.
+  *
+  * \param streams Array of streams
+  * \param count Number of streams
+  * \param timeout Maximum time to run in milliseconds. If zero, every device
+  * is serviced once without waiting. If negative, run until all streams
+  * have ended.
+  * \return The number of streams still active.
+  */
+int RCUStreamRun(struct RCUStream *streams, unsigned int count, int timeout);
+
+/** @} */
+
+/** \defgroup point Points
+ *
+ * \brief Common point tests shared by the other utilities.
+ *
+ *  @{
+ */
+
+/** \brief Check whether a point is lit.
+  *
+  * A point is lit if any of red, green, blue, user1 or user2 is non-zero.
+  * Intensity is not considered, as many projectors ignore it. The
+  * resampling, path optimization and safety zone utilities all use this
+  * rule to tell lit from blanked points.
+  *
+  * \param point Point to test
+  * \return 1 if the point is lit, 0 if it is blanked
+  */
+int RCUPointLit(const struct RCPoint *point);
+
+/** @} */
+
+/** \defgroup pack Packed Point Formats
+ *
+ * \brief Store point data in compact formats and expand it for output.
+ *
+ *  @{
+ */
+
+/** \brief Packed Point Format
+ *
+ * Compact point formats for storing frames. The packed formats store all
+ * values in little endian byte order without padding. RCUFormatRCPoint is
+ * struct RCPoint as is, in host byte order.
+ */
+enum RCUPointFormat {
+  /** struct RCPoint; 16 bytes per point */
+  RCUFormatRCPoint = 0,
+  /** X and Y 16 bit, red, green and blue 8 bit; 7 bytes per point */
+  RCUFormatXY16RGB8 = 1,
+  /** X, Y, red, green and blue 16 bit; 10 bytes per point */
+  RCUFormatXY16RGB16 = 2
+};
+
+/** \brief Query the size of a packed point.
+  *
+  * \param format Point format
+  * \return The number of bytes per point. If the format is unknown,
+  * RCErrorParameterInvalid is returned.
+  */
+int RCUPointSize(enum RCUPointFormat format);
+
+/** \brief Pack points.
+  *
+  * Converts points to a packed format. Intensity, user1 and user2 are
+  * dropped; with RCUFormatXY16RGB8 only the upper 8 bits of the colors
+  * are kept.
+  *
+  * \param format Point format of dst
+  * \param src Points to pack
+  * \param dst Buffer of at least count * RCUPointSize(format) bytes
+  * \param count Number of points
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUPackPoints(enum RCUPointFormat format, const struct RCPoint *src, void *dst, unsigned int count);
+
+/** \brief Unpack points.
+  *
+  * Expands packed points to struct RCPoint. 8 bit colors are scaled to the
+  * full 16 bit range. Intensity is set to the brightest of red, green and
+  * blue; user1 and user2 are set to 0.
+  *
+  * \param format Point format of src
+  * \param src Packed points
+  * \param dst Buffer for count points
+  * \param count Number of points
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUUnpackPoints(enum RCUPointFormat format, const void *src, struct RCPoint *dst, unsigned int count);
+
+/** \brief Write a packed frame.
+  *
+  * Unpacks the frame into scratch and writes it with RCWriteFrame().
+  * Frames in RCUFormatRCPoint are written directly without using scratch.
+  *
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param format Point format of points
+  * \param points Packed points
+  * \param count Number of points
+  * \param speed Sampling rate in Hz, see RCWriteFrame()
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \param scratch Buffer for count points; may be reused for every frame
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUWriteFramePacked(int handle, enum RCUPointFormat format, const void *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch);
+
+/** @} */
+
+/** \defgroup multi Multiple Devices
+ *
+ * \brief Start and write several devices together.
+ *
+ * The device library has no synchronised start. These functions keep the
+ * calls for all devices back to back, so the skew between the devices is
+ * the duration of the RCStartOutput() / RCWriteFrame() calls only and does
+ * not include any waiting for free buffers.
+ *
+ *  @{
+ */
+
+/** \brief Start output on several devices.
+  *
+  * Starts the output of all devices. If starting one device fails, the
+  * devices started before are stopped again.
+  *
+  * \param handles Device handles as obtained by RCOpenDevice()
+  * \param count Number of devices
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUStartOutputSynchronized(const int *handles, unsigned int count);
+
+/** \brief Write frames to several devices.
+  *
+  * Waits until every device has a free buffer and then writes the frames to
+  * all devices back to back. A device whose RCWaitForReady() fails is
+  * skipped; the frames for the other devices are still written.
+  *
+  * \param handles Device handles as obtained by RCOpenDevice()
+  * \param points Point array for each device
+  * \param counts Number of points for each device
+  * \param count Number of devices
+  * \param speed Sampling rate in Hz, see RCWriteFrame()
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \return RCOk on success. If an error occured for any device, the
+  * negative RCReturnCode error code of the first failing device is returned.
+  */
+int RCUWriteFrames(const int *handles, const struct RCPoint *const *points, const unsigned int *counts, unsigned int count, unsigned int speed, unsigned int repeat);
+
+/** @} */
+
+/** \defgroup fifo Point FIFO
+ *
+ * \brief Push point chunks of any size and query the fill level.
+ *
+ * The FIFO collects pushed points into chunks of a fixed size and writes
+ * every complete chunk as a frame that is played once (repeat = 1). Small
+ * chunks keep the latency low: at most the device buffers plus one chunk
+ * are queued.
+ *
+ * The device library only reports the number of free buffers, so the fill
+ * level is computed on the host from the points written and the sampling
+ * rate, assuming the device plays without interruption.
+ *
+ *  @{
+ */
+
+/**
+ * @brief FIFO State
+ *
+ * Initialise with RCUFifoInit(), release with RCUFifoFree().
+ */
+struct RCUFifo {
+  /** Device handle; output must have been started with RCStartOutput() */
+  int handle;
+  /** Sampling rate in Hz */
+  unsigned int speed;
+  /** Points collected for the next chunk */
+  struct RCPoint *chunk;
+  /** Chunk size in points */
+  unsigned int chunkSize;
+  /** Number of points in chunk */
+  unsigned int fill;
+  /** Clock time in microseconds when all written points have been played */
+  long long playEnd;
+  /** Total number of points written to the device */
+  unsigned long long pointsWritten;
+  /** Last point pushed; its position is kept while padding with blanked points */
+  struct RCPoint last;
+};
+
+/** \brief Initialise a FIFO.
+  *
+  * \param fifo FIFO to initialise
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param chunkSize Number of points written per frame
+  * \param speed Sampling rate in Hz
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUFifoInit(struct RCUFifo *fifo, int handle, unsigned int chunkSize, unsigned int speed);
+
+/** \brief Release the chunk buffer of a FIFO.
+  *
+  * \param fifo FIFO initialised with RCUFifoInit()
+  */
+void RCUFifoFree(struct RCUFifo *fifo);
+
+/** \brief Push points.
+  *
+  * Appends points to the FIFO. Every completed chunk is written to the
+  * device; if all device buffers are in use this waits for a free buffer.
+  *
+  * \param fifo FIFO initialised with RCUFifoInit()
+  * \param points Points to append
+  * \param count Number of points
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUFifoPush(struct RCUFifo *fifo, const struct RCPoint *points, unsigned int count);
+
+/** \brief Write the incomplete chunk.
+  *
+  * \param fifo FIFO initialised with RCUFifoInit()
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUFifoFlush(struct RCUFifo *fifo);
+
+/** \brief Query the number of queued points.
+  *
+  * \param fifo FIFO initialised with RCUFifoInit()
+  * \return The number of points pushed but not yet played, including the
+  * points of the incomplete chunk.
+  */
+unsigned int RCUFifoQueued(const struct RCUFifo *fifo);
+
+/** \brief Query the play-out time remaining.
+  *
+  * \param fifo FIFO initialised with RCUFifoInit()
+  * \return The time in microseconds until all queued points have been
+  * played, including the points of the incomplete chunk.
+  */
+long long RCUFifoQueuedTime(const struct RCUFifo *fifo);
+
+/** \brief Query when the next point will be played.
+  *
+  * Maps the position of the next pushed point in the output stream to the
+  * monotonic clock.
+  *
+  * \param fifo FIFO initialised with RCUFifoInit()
+  * \return The RCUClock() time in microseconds at which the next pushed
+  * point will be output.
+  */
+long long RCUFifoPlayTime(const struct RCUFifo *fifo);
+
+/** \brief Push points for output at a given time.
+  *
+  * Pads the FIFO with blanked points at the position of the last pushed
+  * point so that the first of the given points is output at
+  * presentationTime, then pushes the points. Like RCUFifoPush() this waits
+  * while the device buffers are in use, so it returns about one queue
+  * length before presentationTime.
+  *
+  * \param fifo FIFO initialised with RCUFifoInit()
+  * \param points Points to push
+  * \param count Number of points
+  * \param presentationTime RCUClock() time in microseconds at which the
+  * first point should be output. If that time has already passed, the
+  * points are pushed without padding.
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUFifoPushAt(struct RCUFifo *fifo, const struct RCPoint *points, unsigned int count, long long presentationTime);
+
+/** @} */
+
+/** \defgroup latest Latest Frame
+ *
+ * \brief Submit frames without blocking; newer frames replace older ones.
+ *
+ * For live input the newest frame matters, not every frame. Frames are
+ * submitted to a slot that holds at most one frame. A submitted frame
+ * replaces a frame that has not been written to the device yet, and it is
+ * only written while at most one frame is in the device buffers, so the
+ * output lags the input by at most one frame.
+ *
+ *  @{
+ */
+
+/**
+ * @brief Latest Frame Slot
+ *
+ * Initialise with RCULatestInit(), release with RCULatestFree().
+ */
+struct RCULatest {
+  /** Device handle; output must have been started with RCStartOutput() */
+  int handle;
+  /** Pending frame */
+  struct RCPoint *points;
+  /** Capacity of points */
+  unsigned int maxPoints;
+  /** Number of points of the pending frame, 0 if no frame is pending */
+  unsigned int count;
+  /** Sampling rate of the pending frame */
+  unsigned int speed;
+  /** Repeat count of the pending frame */
+  unsigned int repeat;
+  /** Highest number of free buffers reported by the device */
+  int buffers;
+  /** Number of frames replaced before they were written */
+  unsigned long dropped;
+};
+
+/** \brief Initialise a slot.
+  *
+  * \param latest Slot to initialise
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param maxPoints Maximum number of points per frame
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCULatestInit(struct RCULatest *latest, int handle, unsigned int maxPoints);
+
+/** \brief Release the frame buffer of a slot.
+  *
+  * \param latest Slot initialised with RCULatestInit()
+  */
+void RCULatestFree(struct RCULatest *latest);
+
+/** \brief Submit a frame.
+  *
+  * Stores the frame in the slot, replacing a pending frame, and writes it if
+  * the device is ready. Never waits.
+  *
+  * \param latest Slot initialised with RCULatestInit()
+  * \param points Points of the frame
+  * \param count Number of points
+  * \param speed Sampling rate in Hz, see RCWriteFrame()
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \return 1 if the frame was written, 0 if it is pending. If an error occured,
+  * a negative value indicating one of the RCReturnCode error codes is returned.
+  */
+int RCULatestSubmit(struct RCULatest *latest, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat);
+
+/** \brief Write the pending frame if the device is ready.
+  *
+  * Call this regularly, e.g. from the render loop, to write a pending frame
+  * once the device has played the previous one. Never waits.
+  *
+  * \param latest Slot initialised with RCULatestInit()
+  * \return 1 if a frame was written, 0 if not. If an error occured, a negative
+  * value indicating one of the RCReturnCode error codes is returned.
+  */
+int RCULatestPump(struct RCULatest *latest);
+
+/** @} */
+
+/** \defgroup stats Output Statistics
+ *
+ * \brief Count frames, points and errors and measure call latencies.
+ *
+ * Use RCUStatsWaitForReady() and RCUStatsWriteFrame() in place of
+ * RCWaitForReady() and RCWriteFrame() to collect statistics per device.
+ * A statistics structure must only be updated by one thread at a time;
+ * use one per device. Other threads, e.g. a monitoring exporter, read it
+ * with RCUStatsSnapshot() while the output is running.
+ *
+ *  @{
+ */
+
+/** Number of latency histogram buckets */
+#define RCU_STATS_BUCKETS 24
+
+/**
+ * @brief Output Statistics
+ *
+ * Latency histograms count calls by duration: bucket 0 counts calls that
+ * took less than 2 microseconds, bucket i counts calls that took 2^i to
+ * 2^(i+1) - 1 microseconds, the last bucket counts all longer calls.
+ */
+struct RCUOutputStats {
+  /** Frames written successfully */
+  unsigned long long frames;
+  /** Points written successfully */
+  unsigned long long points;
+  /** Failed RCWaitForReady() and RCWriteFrame() calls */
+  unsigned long long errors;
+  /** Frames written while all device buffers were free, i.e. the device
+   * had run out of frames */
+  unsigned long long underruns;
+  /** Highest number of free buffers reported by the device */
+  int buffers;
+  /** Number of buffers in use when the last frame was written */
+  int queueDepth;
+  /** Duration of RCWriteFrame() calls */
+  unsigned long long writeLatency[RCU_STATS_BUCKETS];
+  /** Time blocked in RCWaitForReady() */
+  unsigned long long waitLatency[RCU_STATS_BUCKETS];
+  /** Held while the statistics are updated or copied; 0 when free */
+  volatile long lock;
+};
+
+/** \brief Reset statistics.
+  *
+  * Also initialises the statistics; must not be called while another
+  * thread uses them.
+  *
+  * \param stats Statistics to reset
+  */
+void RCUStatsReset(struct RCUOutputStats *stats);
+
+/** \brief Copy statistics while they are being updated.
+  *
+  * Takes a consistent copy of all counters and histograms. May be called
+  * from any thread while another thread collects statistics; the updating
+  * thread is only held up for the duration of the copy.
+  *
+  * \param stats Statistics of the device
+  * \param snapshot Receives the copy
+  */
+void RCUStatsSnapshot(struct RCUOutputStats *stats, struct RCUOutputStats *snapshot);
+
+/** \brief Wait for a buffer and collect statistics.
+  *
+  * Calls RCWaitForReady() and records the time blocked.
+  *
+  * \param stats Statistics of the device
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param timeout See RCWaitForReady()
+  * \return See RCWaitForReady()
+  */
+int RCUStatsWaitForReady(struct RCUOutputStats *stats, int handle, int timeout);
+
+/** \brief Write a frame and collect statistics.
+  *
+  * Polls the number of free buffers to detect underruns, calls
+  * RCWriteFrame() and records the duration of the call.
+  *
+  * \param stats Statistics of the device
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param points See RCWriteFrame()
+  * \param count See RCWriteFrame()
+  * \param speed See RCWriteFrame()
+  * \param repeat See RCWriteFrame()
+  * \return See RCWriteFrame()
+  */
+int RCUStatsWriteFrame(struct RCUOutputStats *stats, int handle, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat);
+
+/** @} */
+
+/** \defgroup discovery Device Discovery
+ *
+ * \brief Discover devices in the background and report arrivals and removals.
+ *
+ * A discovery thread calls RCEnumerateDevices() periodically, keeps a list
+ * of the devices found and calls a callback when a device appears or
+ * disappears, e.g. after a USB device was unplugged or a NET device
+ * rebooted. The calling thread never waits for an enumeration.
+ *
+ * While the discovery runs, the device list of the library is owned by the
+ * discovery thread: do not call RCEnumerateDevices() or RCDeviceID(), use
+ * RCUDiscoveryCount() and RCUDiscoveryDeviceID() instead. Open devices with
+ * RCUDiscoveryOpen(), which waits for a running enumeration to end; call
+ * RCOpenDevice() directly only from the device callback.
+ *
+ *  @{
+ */
+
+/** Maximum number of devices in the discovery list */
+#define RCU_DISCOVERY_MAX_DEVICES 64
+/** Minimum time between enumerations in milliseconds */
+#define RCU_DISCOVERY_MIN_INTERVAL 100
+
+/** \brief Device Event
+ *
+ * Events reported to the device callback.
+ */
+enum RCUDeviceEvent {
+  /** A device has been found */
+  RCUDeviceArrived = 0,
+  /** A device is no longer found */
+  RCUDeviceLeft = 1
+};
+
+/** \brief Device callback
+ *
+ * Called from the discovery thread when a device appears or disappears,
+ * between enumerations. Opening a device that arrived with RCOpenDevice()
+ * or RCUDiscoveryOpen() from the callback is allowed.
+ *
+ * \param event Type of the event
+ * \param deviceId Device ID string of the device, see RCDeviceID()
+ * \param userData User data passed to RCUDiscoveryStart()
+ */
+typedef void (*RCUDeviceCallback)(enum RCUDeviceEvent event, const char *deviceId, void *userData);
+
+/** Discovery state; created by RCUDiscoveryStart() */
+struct RCUDiscovery;
+
+/** \brief Start device discovery.
+  *
+  * Starts the discovery thread. The first enumeration runs in the
+  * background; every device found is reported with RCUDeviceArrived.
+  * RCInit() must have been called before.
+  *
+  * \param interval Time between enumerations in milliseconds; enumeration
+  * rescans the USB and network devices, so smaller values than
+  * RCU_DISCOVERY_MIN_INTERVAL are raised to it
+  * \param callback Device callback, may be NULL
+  * \param userData User data passed to the callback
+  * \return The discovery state, or NULL if the thread could not be started.
+  */
+struct RCUDiscovery *RCUDiscoveryStart(unsigned int interval, RCUDeviceCallback callback, void *userData);
+
+/** \brief Stop device discovery.
+  *
+  * Waits for the discovery thread to end and releases the discovery state.
+  *
+  * \param discovery Discovery state as returned by RCUDiscoveryStart()
+  */
+void RCUDiscoveryStop(struct RCUDiscovery *discovery);
+
+/** \brief Query the number of discovered devices.
+  *
+  * \param discovery Discovery state as returned by RCUDiscoveryStart()
+  * \return The number of devices found by the last enumeration.
+  */
+int RCUDiscoveryCount(struct RCUDiscovery *discovery);
+
+/** \brief Read a discovered device ID.
+  *
+  * \param discovery Discovery state as returned by RCUDiscoveryStart()
+  * \param index Index in the device list. Range is 0 to the number reported
+  * by RCUDiscoveryCount() - 1.
+  * \param deviceId Buffer for the device ID, see RCDeviceID()
+  * \param maxLength Size of the buffer, see RCDeviceID()
+  * \return The number of characters written to deviceId, including
+  * terminating nul character. If an error occured, a negative value
+  * indicating one of the RCReturnCode error codes is returned.
+  */
+int RCUDiscoveryDeviceID(struct RCUDiscovery *discovery, unsigned int index, char *deviceId, unsigned int maxLength);
+
+/** \brief Open a discovered device.
+  *
+  * Calls RCOpenDevice() between two enumerations of the discovery thread,
+  * so that the device list of the library does not change meanwhile. Use
+  * it instead of RCOpenDevice() from any thread while the discovery runs.
+  *
+  * \param discovery Discovery state as returned by RCUDiscoveryStart()
+  * \param deviceId Device ID string, e.g. from RCUDiscoveryDeviceID()
+  * \return The device handle, see RCOpenDevice(). If an error occured, a
+  * negative value indicating one of the RCReturnCode error codes is
+  * returned.
+  */
+int RCUDiscoveryOpen(struct RCUDiscovery *discovery, const char *deviceId);
+
+/** @} */
+
+/** \defgroup dmx DMX Output Batching
+ *
+ * \brief Write many universe spans at once and send only changed channels.
+ *
+ * Spans for any number of output universes on any number of devices are
+ * staged with RCUDmxWrite() and compared against the values sent before.
+ * RCUDmxFlush() then writes, per universe, only the channel range that
+ * changed with a single RCUniverseWrite() and calls RCUniverseUpdate();
+ * universes without changes are skipped entirely.
+ *
+ * The batch owns every universe it writes: channels that were never written
+ * are 0, and the first flush of a universe sends all of its channels, so
+ * the values compared against always match the device.
+ *
+ *  @{
+ */
+
+/** Maximum number of channels per universe */
+#define RCU_DMX_CHANNELS 512
+
+/**
+ * @brief DMX Span
+ *
+ * Channel values for a range of an output universe.
+ */
+struct RCUDmxSpan {
+  /** Device handle as obtained by RCOpenDevice() */
+  int handle;
+  /** Universe index, see RCUniverseWrite() */
+  unsigned int universeIndex;
+  /** First channel; 0 is the first DMX channel */
+  unsigned int startChannel;
+  /** Channel values */
+  const unsigned char *data;
+  /** Number of channels */
+  unsigned int count;
+};
+
+/**
+ * @brief DMX Universe State
+ *
+ * Staged channel values of one universe.
+ */
+struct RCUDmxUniverse {
+  /** Device handle */
+  int handle;
+  /** Universe index */
+  unsigned int universeIndex;
+  /** Channel count as reported by RCUniverseQuery() */
+  unsigned int channels;
+  /** Changed channels not sent yet are in the range dirtyStart to dirtyEnd - 1 */
+  unsigned int dirtyStart;
+  /** End of the changed channel range; equal to dirtyStart if nothing changed */
+  unsigned int dirtyEnd;
+  /** Non-zero once the universe has been sent completely; before that every
+   * written channel counts as changed and the next flush sends all channels */
+  int sent;
+  /** Channel values */
+  unsigned char data[RCU_DMX_CHANNELS];
+};
+
+/**
+ * @brief DMX Batch State
+ *
+ * Initialise with RCUDmxInit(), release with RCUDmxFree().
+ */
+struct RCUDmx {
+  /** Universes written so far */
+  struct RCUDmxUniverse *universes;
+  /** Number of universes */
+  unsigned int count;
+  /** Capacity of universes */
+  unsigned int maxUniverses;
+};
+
+/** \brief Initialise a DMX batch.
+  *
+  * \param dmx Batch to initialise
+  * \param maxUniverses Maximum number of universes written through the batch
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUDmxInit(struct RCUDmx *dmx, unsigned int maxUniverses);
+
+/** \brief Release a DMX batch.
+  *
+  * \param dmx Batch initialised with RCUDmxInit()
+  */
+void RCUDmxFree(struct RCUDmx *dmx);
+
+/** \brief Stage channel values.
+  *
+  * Copies the spans into the batch and marks the channels whose values
+  * changed. Nothing is sent to the devices.
+  *
+  * \param dmx Batch initialised with RCUDmxInit()
+  * \param spans Spans to write
+  * \param count Number of spans
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned; spans before the failing
+  * one have been staged.
+  */
+int RCUDmxWrite(struct RCUDmx *dmx, const struct RCUDmxSpan *spans, unsigned int count);
+
+/** \brief Send changed channels.
+  *
+  * For every universe with changed channels, writes the changed range and
+  * flushes the universe with RCUniverseUpdate(). The first flush of a
+  * universe writes all of its channels.
+  *
+  * \param dmx Batch initialised with RCUDmxInit()
+  * \return The number of universes updated. If an error occured, a negative
+  * value indicating one of the RCReturnCode error codes is returned; the
+  * universe that failed stays marked as changed.
+  */
+int RCUDmxFlush(struct RCUDmx *dmx);
+
+/** @} */
+
+/** \defgroup dmxin DMX Input Changes
+ *
+ * \brief Wait for changes of an input universe.
+ *
+ * The device library does not signal new DMX input, so the input universe
+ * is read at a fixed poll interval while waiting. Compared with polling in
+ * the application this sleeps between reads, so waiting costs almost no
+ * CPU, and it reports which channels changed.
+ *
+ *  @{
+ */
+
+/**
+ * @brief DMX Input State
+ *
+ * Initialise with RCUDmxInputInit().
+ */
+struct RCUDmxInput {
+  /** Device handle */
+  int handle;
+  /** Universe index */
+  unsigned int universeIndex;
+  /** Channel count as reported by RCUniverseQuery() */
+  unsigned int channels;
+  /** Time between reads while waiting in microseconds */
+  unsigned int pollInterval;
+  /** Channel values as of the last reported change */
+  unsigned char data[RCU_DMX_CHANNELS];
+};
+
+/** \brief Initialise a DMX input.
+  *
+  * Reads the current values of the input universe.
+  *
+  * \param input Input to initialise
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param universeIndex Index of an input universe, see RCUniverseQuery()
+  * \param pollInterval Time between reads while waiting in microseconds;
+  * 1000 is a good value, DMX frames are at least 22 ms apart.
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUDmxInputInit(struct RCUDmxInput *input, int handle, unsigned int universeIndex, unsigned int pollInterval);
+
+/** \brief Wait for changed input.
+  *
+  * Waits until a channel value differs from input->data. input->data is then
+  * updated and the changed channels are reported.
+  *
+  * \param input Input initialised with RCUDmxInputInit()
+  * \param timeout Maximum time to wait in milliseconds. If zero, checks once
+  * without waiting; if negative, waits without timing out.
+  * \param pFirstChannel Set to the first changed channel; may be NULL
+  * \param pEndChannel Set to the last changed channel + 1; may be NULL
+  * \return 1 if channels changed, 0 if the timeout elapsed. If an error
+  * occured, a negative value indicating one of the RCReturnCode error codes
+  * is returned.
+  */
+int RCUDmxInputWait(struct RCUDmxInput *input, int timeout, unsigned int *pFirstChannel, unsigned int *pEndChannel);
+
+/** @} */
+
+/** \defgroup ilda ILDA Files
+ *
+ * \brief Play ILDA (.ild) files.
+ *
+ * The file is memory mapped, so opening is immediate regardless of the file
+ * size. Frame positions are indexed lazily from the section headers as
+ * frames are requested. Formats 0, 1, 4 and 5 are decoded; palettes
+ * (format 2) apply to the indexed frames following them, otherwise the
+ * ILDA default palette is used. Format 3 sections are skipped.
+ *
+ *  @{
+ */
+
+/** ILDA file state; created by RCUIldaOpen() */
+struct RCUIlda;
+
+/** \brief Open an ILDA file.
+  *
+  * \param path Path of the file
+  * \return The file state, or NULL if the file could not be opened or is
+  * not an ILDA file.
+  */
+struct RCUIlda *RCUIldaOpen(const char *path);
+
+/** \brief Close an ILDA file.
+  *
+  * \param ilda File state as returned by RCUIldaOpen()
+  */
+void RCUIldaClose(struct RCUIlda *ilda);
+
+/** \brief Query the number of frames.
+  *
+  * Indexes the remaining section headers of the file.
+  *
+  * \param ilda File state as returned by RCUIldaOpen()
+  * \return The number of frames. If an error occured, a negative value
+  * indicating one of the RCReturnCode error codes is returned.
+  */
+int RCUIldaFrameCount(struct RCUIlda *ilda);
+
+/** \brief Decode a frame.
+  *
+  * ILDA coordinates map directly to RCPoint x and y, 8 bit colors are
+  * scaled to 16 bit, blanked points get all colors 0. Intensity is set to the
+  * brightest color, user1 and user2 to 0.
+  *
+  * \param ilda File state as returned by RCUIldaOpen()
+  * \param index Frame index, starting at 0
+  * \param points Buffer for the points
+  * \param maxPoints Capacity of points. If 0, only the number of points of
+  * the frame is returned.
+  * \return The number of points of the frame. If an error occured, a negative
+  * value indicating one of the RCReturnCode error codes is returned;
+  * RCErrorParameterOutOfRange if the frame does not exist or does not fit
+  * into points.
+  */
+int RCUIldaDecodeFrame(struct RCUIlda *ilda, unsigned int index, struct RCPoint *points, unsigned int maxPoints);
+
+/** \brief Write a frame to a device.
+  *
+  * Decodes the frame into a buffer owned by the file state and writes it
+  * with RCWriteFrame(). The operating system is asked to read ahead the
+  * following frames, so playing a large file does not stall on disk reads.
+  *
+  * \param ilda File state as returned by RCUIldaOpen()
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param index Frame index, starting at 0
+  * \param speed Sampling rate in Hz, see RCWriteFrame()
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUIldaWriteFrame(struct RCUIlda *ilda, int handle, unsigned int index, unsigned int speed, unsigned int repeat);
+
+/** @} */
+
+/** \defgroup correct Output Correction
+ *
+ * \brief Per projector geometry and color correction.
+ *
+ * A correction combines a projective transform of the XY coordinates
+ * (keystone, scaling, rotation, offset) with a lookup table per color
+ * channel (color balance, gamma). It is applied while copying a frame to
+ * the buffer that is written to the device. Points that a projective
+ * transform puts behind the projection center (w <= 0) are blanked.
+ *
+ *  @{
+ */
+
+/** Number of entries of a correction lookup table */
+#define RCU_LUT_SIZE 256
+
+/** \brief Color Channel
+ *
+ * Channels of struct RCPoint that can be corrected with a lookup table.
+ */
+enum RCUColorChannel {
+  /** Red */
+  RCUChannelRed = 0,
+  /** Green */
+  RCUChannelGreen = 1,
+  /** Blue */
+  RCUChannelBlue = 2,
+  /** Intensity */
+  RCUChannelIntensity = 3,
+  /** User 1 */
+  RCUChannelUser1 = 4,
+  /** User 2 */
+  RCUChannelUser2 = 5,
+  /** Number of channels */
+  RCUChannelCount = 6
+};
+
+/**
+ * @brief Output Correction
+ *
+ * Initialise with RCUCorrectionInit().
+ */
+struct RCUCorrection {
+  /** 3x3 transform matrix in row-major order, applied to (x, y, 1) with x and
+   * y scaled to the range -1 to 1 */
+  float matrix[9];
+  /** Non-zero if the last row of matrix is (0, 0, 1) */
+  int affine;
+  /** Lookup tables; entry i is the output for input i * 257, values in
+   * between are interpolated linearly */
+  unsigned short luts[RCUChannelCount][RCU_LUT_SIZE];
+};
+
+/** \brief Initialise a correction.
+  *
+  * Sets the identity transform and identity lookup tables.
+  *
+  * \param correction Correction to initialise
+  */
+void RCUCorrectionInit(struct RCUCorrection *correction);
+
+/** \brief Set the transform.
+  *
+  * \param correction Correction initialised with RCUCorrectionInit()
+  * \param matrix 3x3 matrix in row-major order. It maps (x, y, 1) to
+  * (x', y', w), the output position is (x' / w, y' / w); coordinates are
+  * scaled to the range -1 to 1.
+  * \return RCOk on success, RCErrorParameterInvalid if matrix is NULL.
+  */
+int RCUCorrectionSetTransform(struct RCUCorrection *correction, const float matrix[9]);
+
+/** \brief Set the lookup table of a channel.
+  *
+  * \param correction Correction initialised with RCUCorrectionInit()
+  * \param channel Channel to set
+  * \param table RCU_LUT_SIZE output values for the inputs 0, 257, 514, ...,
+  * 65535
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUCorrectionSetLUT(struct RCUCorrection *correction, enum RCUColorChannel channel, const unsigned short table[RCU_LUT_SIZE]);
+
+/** \brief Set a gamma curve for a channel.
+  *
+  * Fills the lookup table of the channel with
+  * output = scale * 65535 * (input / 65535) ^ gamma.
+  *
+  * \param correction Correction initialised with RCUCorrectionInit()
+  * \param channel Channel to set
+  * \param gamma Gamma exponent; 1.0 is linear
+  * \param scale Output scale from 0.0 to 1.0, e.g. for color balance
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUCorrectionSetGamma(struct RCUCorrection *correction, enum RCUColorChannel channel, double gamma, double scale);
+
+/** \brief Apply a correction.
+  *
+  * \param correction Correction initialised with RCUCorrectionInit()
+  * \param src Points to correct
+  * \param dst Buffer for the corrected points; may be equal to src
+  * \param count Number of points
+  */
+void RCUCorrectionApply(const struct RCUCorrection *correction, const struct RCPoint *src, struct RCPoint *dst, unsigned int count);
+
+/** \brief Write a corrected frame.
+  *
+  * Applies the correction while copying the frame to scratch and writes it
+  * with RCWriteFrame().
+  *
+  * \param correction Correction initialised with RCUCorrectionInit()
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param points Points of the frame
+  * \param count Number of points
+  * \param speed Sampling rate in Hz, see RCWriteFrame()
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \param scratch Buffer for count points; may be reused for every frame
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUCorrectionWriteFrame(const struct RCUCorrection *correction, int handle, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch);
+
+/** @} */
+
+/** \defgroup resample Resampling
+ *
+ * \brief Output of content at sampling rates above the device maximum.
+ *
+ * Frames are resampled to a lower rate while keeping their duration.
+ * Positions are interpolated linearly, colors are held from the preceding
+ * source point so no new colors appear. Blanking transitions and sharp
+ * corners are kept as exact source points instead of being interpolated
+ * away, and no position is interpolated across a blanking transition.
+ * Points are lit or blanked as defined by RCUPointLit().
+ *
+ *  @{
+ */
+
+/** \brief Number of points after resampling.
+  *
+  * \param count Number of source points
+  * \param speed Sampling rate of the source points in Hz
+  * \param targetSpeed Sampling rate to resample to in Hz
+  * \return Number of points RCUResample() produces, or a negative
+  * RCReturnCode error code if a rate is zero.
+  */
+int RCUResampleCount(unsigned int count, unsigned int speed, unsigned int targetSpeed);
+
+/** \brief Resample points.
+  *
+  * \param src Source points
+  * \param count Number of source points
+  * \param speed Sampling rate of the source points in Hz
+  * \param dst Buffer for the resampled points
+  * \param maxCount Size of dst in points, at least RCUResampleCount()
+  * \param targetSpeed Sampling rate to resample to in Hz; must not exceed speed
+  * \return The number of points written to dst. If an error occured,
+  * a negative value indicating one of the RCReturnCode error codes is returned.
+  */
+int RCUResample(const struct RCPoint *src, unsigned int count, unsigned int speed, struct RCPoint *dst, unsigned int maxCount, unsigned int targetSpeed);
+
+/** \brief Write a frame, resampling it if the device is too slow.
+  *
+  * If speed exceeds RCMaxSpeed() of the device the frame is resampled to
+  * the maximum speed of the device, otherwise it is written unchanged.
+  * This allows a single content stream to feed devices with different
+  * maximum sampling rates.
+  *
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param points Points of the frame
+  * \param count Number of points
+  * \param speed Sampling rate in Hz, see RCWriteFrame()
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \param scratch Buffer for the resampled frame; may be reused for every
+  * frame. count points are always sufficient.
+  * \param scratchCount Size of scratch in points
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUWriteFrameResampled(int handle, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch, unsigned int scratchCount);
+
+/** @} */
+
+/** \defgroup optimize Path Optimization
+ *
+ * \brief Reordering of frames and insertion of blanking and dwell points.
+ *
+ * The lit parts of a frame are split into segments, which are reordered
+ * and reversed to shorten the blanked moves between them: a nearest
+ * neighbour tour on a grid index, improved by 2-opt passes. Blanked moves
+ * are then regenerated with a point count adapted to their length, and
+ * dwell points are added at segment ends and corners according to a
+ * scanner profile.
+ *
+ * The optimized frame is a closed loop: it starts at the first segment and
+ * ends with the blanked move back to it, so it can be written with any
+ * repeat count. The first segment is the one closest to where the previous
+ * frame started, keeping the jump between frames short.
+ *
+ *  @{
+ */
+
+/**
+ * @brief Scanner Profile
+ *
+ * Initialise with RCUScannerProfileInit() and adjust to the scanners.
+ */
+struct RCUScannerProfile {
+  /** Maximum distance between the points of a blanked move */
+  unsigned int blankStep;
+  /** Blanked points at the end of a segment before moving, while the laser
+   * turns off */
+  unsigned int blankBefore;
+  /** Blanked points at the start of a segment after moving, while the
+   * scanners settle */
+  unsigned int blankAfter;
+  /** Repetitions of the first and last point of a segment */
+  unsigned int endDwell;
+  /** Points added at a 90 degree corner; sharper corners get more, up to
+   * twice this value */
+  unsigned int cornerDwell;
+  /** Number of 2-opt passes; each pass is quadratic in the number of
+   * segments, 0 uses the nearest neighbour order only */
+  unsigned int passes;
+};
+
+/**
+ * @brief Path Optimizer
+ *
+ * Initialise with RCUOptimizerInit(), free with RCUOptimizerFree().
+ */
+struct RCUOptimizer {
+  /** Scanner profile */
+  struct RCUScannerProfile profile;
+  /** Maximum number of source points per frame */
+  unsigned int maxPoints;
+  /** Working memory for maxPoints source points */
+  unsigned int *work;
+  /** Position the previous frame started and ended at */
+  signed short x, y;
+};
+
+/** \brief Initialise a scanner profile with defaults.
+  *
+  * The defaults suit scanners of about 30 kpps at 30000 points per second.
+  *
+  * \param profile Profile to initialise
+  */
+void RCUScannerProfileInit(struct RCUScannerProfile *profile);
+
+/** \brief Initialise an optimizer.
+  *
+  * \param optimizer Optimizer to initialise
+  * \param profile Scanner profile; copied into the optimizer
+  * \param maxPoints Maximum number of points of a source frame
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUOptimizerInit(struct RCUOptimizer *optimizer, const struct RCUScannerProfile *profile, unsigned int maxPoints);
+
+/** \brief Free an optimizer.
+  *
+  * \param optimizer Optimizer initialised with RCUOptimizerInit()
+  */
+void RCUOptimizerFree(struct RCUOptimizer *optimizer);
+
+/** \brief Optimize a frame.
+  *
+  * Blanked points of the source frame, as defined by RCUPointLit(), are
+  * dropped and regenerated.
+  *
+  * \param optimizer Optimizer initialised with RCUOptimizerInit()
+  * \param src Source frame
+  * \param count Number of points in src, at most maxPoints
+  * \param dst Buffer for the optimized frame
+  * \param maxCount Size of dst in points
+  * \return The number of points written to dst. If an error occured,
+  * a negative value indicating one of the RCReturnCode error codes is
+  * returned; RCErrorParameterOutOfRange if dst is too small.
+  */
+int RCUOptimizeFrame(struct RCUOptimizer *optimizer, const struct RCPoint *src, unsigned int count, struct RCPoint *dst, unsigned int maxCount);
+
+/** @} */
+
+/** \defgroup safety Safety Zones
+ *
+ * \brief Blanking of points in forbidden zones and exposure limits.
+ *
+ * Zones are polygons in device coordinates. Every point inside a forbidden
+ * zone is blanked, whatever its color values. So are both ends of every
+ * line between consecutive points that crosses a forbidden zone while one
+ * of its ends is lit; this includes the line from the last point back to
+ * the first.
+ *
+ * Lit points inside a limited zone are counted against an exposure budget
+ * per time window; once the budget is used up, points inside the zone are
+ * blanked until the next window starts. Points are lit as defined by
+ * RCUPointLit(). Limited zones only test the points
+ * themselves: a line passing through a limited zone between two points
+ * outside it is neither counted nor blanked, so frames should be sampled
+ * densely enough that every pass through a limited zone has points in it.
+ *
+ * The zones are applied while copying a frame to the buffer that is
+ * written to the device. They only protect output written with
+ * RCUSafetyWriteFrame(); RCWriteFrame() is not affected.
+ *
+ *  @{
+ */
+
+/** Maximum number of zones */
+#define RCU_SAFETY_MAX_ZONES 16
+/** Maximum number of vertices of a zone */
+#define RCU_SAFETY_MAX_VERTICES 32
+
+/** \brief Zone Type */
+enum RCUZoneType {
+  /** Points inside the zone and lit lines crossing it are always blanked */
+  RCUZoneForbidden = 0,
+  /** Lit points inside the zone are limited by an exposure budget */
+  RCUZoneLimited = 1
+};
+
+/**
+ * @brief Safety Zone
+ *
+ * Added with RCUSafetyAddZone().
+ */
+struct RCUSafetyZone {
+  /** Zone type */
+  enum RCUZoneType type;
+  /** Number of vertices */
+  unsigned int vertexCount;
+  /** Vertices */
+  signed short x[RCU_SAFETY_MAX_VERTICES], y[RCU_SAFETY_MAX_VERTICES];
+  /** Bounding box */
+  signed short minX, minY, maxX, maxY;
+  /** Lit time allowed per window in nanoseconds; limited zones only */
+  long long budget;
+  /** Lit time used in the current window in nanoseconds */
+  long long exposure;
+  /** Number of points blanked by this zone */
+  unsigned long long blanked;
+};
+
+/**
+ * @brief Safety Zones of a Device
+ *
+ * Initialise with RCUSafetyInit().
+ */
+struct RCUSafety {
+  /** Device handle */
+  int handle;
+  /** Exposure window in microseconds */
+  unsigned int window;
+  /** Clock time in microseconds when the current window started */
+  long long windowStart;
+  /** Number of zones */
+  unsigned int zoneCount;
+  /** Zones */
+  struct RCUSafetyZone zones[RCU_SAFETY_MAX_ZONES];
+};
+
+/** \brief Initialise the safety zones of a device.
+  *
+  * \param safety Safety zones to initialise; there are no zones initially
+  * \param handle Device handle as obtained by RCOpenDevice()
+  * \param window Exposure window in microseconds, e.g. 1000000
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUSafetyInit(struct RCUSafety *safety, int handle, unsigned int window);
+
+/** \brief Add a zone.
+  *
+  * \param safety Safety zones initialised with RCUSafetyInit()
+  * \param type Zone type
+  * \param x X coordinates of the vertices
+  * \param y Y coordinates of the vertices
+  * \param vertexCount Number of vertices, 3 to RCU_SAFETY_MAX_VERTICES
+  * \param budget Lit time allowed per window in microseconds for
+  * RCUZoneLimited; ignored for RCUZoneForbidden
+  * \return The index of the zone. If an error occured, a negative value
+  * indicating one of the RCReturnCode error codes is returned.
+  */
+int RCUSafetyAddZone(struct RCUSafety *safety, enum RCUZoneType type, const signed short *x, const signed short *y, unsigned int vertexCount, unsigned int budget);
+
+/** \brief Apply the safety zones to a frame.
+  *
+  * Exposure is accounted for every pass of the frame. A frame written with
+  * repeat 0 plays until it is replaced, so it is accounted as repeating for
+  * a whole window.
+  *
+  * \param safety Safety zones initialised with RCUSafetyInit()
+  * \param src Points of the frame
+  * \param dst Buffer for the masked points; may be equal to src
+  * \param count Number of points
+  * \param speed Sampling rate in Hz, 1 to 1000000000
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUSafetyApply(struct RCUSafety *safety, const struct RCPoint *src, struct RCPoint *dst, unsigned int count, unsigned int speed, unsigned int repeat);
+
+/** \brief Write a frame with the safety zones applied.
+  *
+  * \param safety Safety zones initialised with RCUSafetyInit()
+  * \param points Points of the frame
+  * \param count Number of points
+  * \param speed Sampling rate in Hz, see RCWriteFrame()
+  * \param repeat Repeat count, see RCWriteFrame()
+  * \param scratch Buffer for count points; may be reused for every frame
+  * \return RCOk on success. If an error occured, a negative value indicating
+  * one of the RCReturnCode error codes is returned.
+  */
+int RCUSafetyWriteFrame(struct RCUSafety *safety, const struct RCPoint *points, unsigned int count, unsigned int speed, unsigned int repeat, struct RCPoint *scratch);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAYCOMPOSER_DEVICE_UTIL_H */